@@ -4,8 +4,9 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
+#include "core/rr_blooper.hpp"
 #include <dsp/digital.hpp>
-#include <sys/time.h>
 
 struct Blooper : RRModule {
   enum ParamIds {
@@ -55,31 +56,35 @@ struct Blooper : RRModule {
                   NUM_LIGHTS
   };
 
-  // internal clock measurements
-  struct timeval last_blink_time;
-  double blink_off_until_usec = 0;
-  double blink_off_until_sec = 0;
-
-  // blooper state machine
-  int bypass_state;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {VOLUME_PARAM,    VOLUME_INPUT,    14, 0, 127, RR_CURVE_LINEAR},
+    {LAYERS_PARAM,    LAYERS_INPUT,    15, 0, 127, RR_CURVE_LINEAR},
+    {REPEATS_PARAM,   REPEATS_INPUT,   16, 0, 127, RR_CURVE_LINEAR},
+    {MODA_PARAM,      MODA_INPUT,      17, 0, 127, RR_CURVE_LINEAR},
+    {STABILITY_PARAM, STABILITY_INPUT, 18, 0, 127, RR_CURVE_LINEAR},
+    {MODB_PARAM,      MODB_INPUT,      19, 0, 127, RR_CURVE_LINEAR}
+  };
 
-  // loop select program change number
-  bool program_change;
+  // blooper state machine (see core/rr_blooper.hpp)
+  RRBlooperTransport transport;
 
   // cached next value for modA and modB toggles
   int next_moda_toggle_value = 1;
   int next_modb_toggle_value = 1;
 
-  // grace period timevals
-  struct timeval erase_grace_period, one_shot_grace_period;
-  struct timeval moda_toggle_grace_period, modb_toggle_grace_period, loop_select_grace_period;
+  // grace period start times (timebase seconds)
+  double moda_toggle_grace_period = 0.0;
+  double modb_toggle_grace_period = 0.0;
 
   // gate triggers
-  dsp::SchmittTrigger stop_gate_trigger, play_gate_trigger, record_gate_trigger;
-  dsp::SchmittTrigger moda_gate_trigger, modb_gate_trigger;
+  RRGateBank<5> gates;
 
   Blooper() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({STOP_GATE_INPUT, PLAY_GATE_INPUT, RECORD_GATE_INPUT, MODA_GATE_INPUT, MODB_GATE_INPUT});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(VOLUME_PARAM, 0.f, 127.f, 64.f, "Loop Volume");
@@ -112,122 +117,35 @@ struct Blooper : RRModule {
     configParam(STOP_LOOP_PARAM, 0.f, 1.f, 0.f, "Stop");
     configParam(ERASE_LOOP_PARAM, 0.f, 1.f, 0.f, "Erase");
 
-    // pedal bypass state (play, recording, overdubbing, stopped, erasing, etc...)
-    bypass_state = 0;
-
-    // upon initialization, we won't reset the program change loop
-    program_change = false;
-
-    // blinking rate
-    gettimeofday(&last_blink_time, NULL);
-
-    // initialize te mod toggle grace periods
-    gettimeofday(&moda_toggle_grace_period, NULL);
-    gettimeofday(&modb_toggle_grace_period, NULL);
-
-    // initialize the loop select grace period
-    gettimeofday(&loop_select_grace_period, NULL);
-  }
-
-  void record() {
-    // disable one shot record
-    reset_one_shot(false);
-
-    // send a record message
-    midi_out.sendCachedCC(1, 11);
-  }
-
-  void play() {
-    // disable one shot record
-    reset_one_shot(false);
-
-    // send a play message
-    midi_out.sendCachedCC(2, 11);
-  }
-
-  void over_dub() {
-    // disable one shot record
-    reset_one_shot(false);
-
-    // send an over dub message
-    midi_out.sendCachedCC(3, 11);
-  }
-
-  void stop() {
-    // disable one shot record
-    reset_one_shot(false);
-
-    // send a stop message
-    midi_out.sendCachedCC(4, 11);
-  }
-
-  void erase() {
-    // disable one shot record
-    reset_one_shot(false);
-
-    // send an erase message
-    midi_out.sendCachedCC(7, 11);
-
-    // collect a timestamp to know when the
-    // erase grace period starts
-    gettimeofday(&erase_grace_period, NULL);
-  }
-
-  void one_shot_record() {
-    // enable one shot record
-    midi_out.sendCachedCC(1, 9);
-
-    // collect a timestamp to know when the one shot grace period starts
-    gettimeofday(&one_shot_grace_period, NULL);
+    // transport commands (record, play, stop, ...), one shot record and the
+    // modifier toggles can't wait behind the knobs
+    midi_out.setPriorityCC(11);
+    midi_out.setPriorityCC(9);
+    midi_out.setPriorityCC(30);
+    midi_out.setPriorityCC(31);
   }
 
-  void reset_one_shot(bool reset_cache) {
-    if (reset_cache)
-      midi_out.resetCCCache(9);
-    midi_out.sendCachedCC(0, 9);
+  bool timers_idle() override {
+    // the stopped, erasing, one shot and loop change states flash the
+    // LEDs and time out on their own
+    if (transport.timers_running())
+      return false;
+
+    // held buttons repeat after their grace period
+    return params[TOGGLE_MODA_PARAM].getValue() == 0.f
+      && params[TOGGLE_MODB_PARAM].getValue() == 0.f
+      && params[LOOP_SELECT_INCR_PARAM].getValue() == 0.f
+      && params[LOOP_SELECT_DECR_PARAM].getValue() == 0.f
+      && params[RECORD_LOOP_PARAM].getValue() == 0.f
+      && params[PLAY_LOOP_PARAM].getValue() == 0.f
+      && params[STOP_LOOP_PARAM].getValue() == 0.f
+      && params[ERASE_LOOP_PARAM].getValue() == 0.f;
   }
 
-  float flash_led(float blink_rate) {
-    // collect a current time stamp and compare it to a previously stored time stamp
-    // measure the amount of time from the previous LED flash
-    double last_time_usec = (double) last_blink_time.tv_usec;
-    double last_time_sec = (double) last_blink_time.tv_sec;
-
-    // get a new measurement
-    struct timeval ctime;
-    gettimeofday(&ctime, NULL);
-    double this_time_usec = (double) ctime.tv_usec;
-    double this_time_sec = (double) ctime.tv_sec;
-
-    // determine if we are in the blink off period by checking
-    // if the current time has not breached the blink off time window
-    double blink_off_diff_sec = this_time_sec - blink_off_until_sec;
-    double blink_off_diff_usec = this_time_usec - blink_off_until_usec;
-    float blink_off_diff = (float) (blink_off_diff_sec + (blink_off_diff_usec/1000000));
-    if (blink_off_diff < 0) {
-      // we are in the quiet period
-      return 0.f;
-    }
-
-    // calculate how much time has gone by
-    double diff_sec = this_time_sec - last_time_sec;
-    double diff_usec = this_time_usec - last_time_usec;
-    float diff = (float) (diff_sec + (diff_usec/1000000));
-
-    // if the time diff has exceeded the blink rate, then make now be the last time
-    // we blinked, and return a brightness of 0
-    if (diff > blink_rate) {
-      last_blink_time = ctime;
-      blink_off_until_usec = (double) this_time_usec + 100000;
-      blink_off_until_sec = (double) this_time_sec;
-      return 0.f;
-    } else {
-      // we don't need to blink yet, keep the light on
-      return 1.f;
-    }
-  }
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
 
-  void process(const ProcessArgs& args) override {
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -243,6 +161,10 @@ struct Blooper : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do
+    if (is_idle())
+      return;
+
     // handle a clock message
     if (inputs[CLOCK_INPUT].isConnected()) {
       bool clock = inputs[CLOCK_INPUT].getVoltage() >= 1.f;
@@ -258,57 +180,48 @@ struct Blooper : RRModule {
     int r_toggle = (int) floor(params[R_TOGGLE_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(l_toggle, 21);
-    midi_out.sendCachedCC(m_toggle, 22);
-    midi_out.sendCachedCC(r_toggle, 23);
-
-    // read the mod a and mod b gate triggers
-    bool moda_triggered = false;
-    if (inputs[MODA_GATE_INPUT].isConnected()) {
-      if (moda_gate_trigger.process(rescale(inputs[MODA_GATE_INPUT].getVoltage(),
-                                            0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, toggle the moda param
-        params[TOGGLE_MODA_PARAM].setValue(1.f);
-        moda_triggered = true;
-      }
-    }
-    bool modb_triggered = false;
-    if (inputs[MODB_GATE_INPUT].isConnected()) {
-      if (modb_gate_trigger.process(rescale(inputs[MODB_GATE_INPUT].getVoltage(),
-                                            0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, toggle the modb param
-        params[TOGGLE_MODB_PARAM].setValue(1.f);
-        modb_triggered = true;
-      }
-    }
+    midi_out.sendCachedCCNow(l_toggle, 21);
+    midi_out.sendCachedCCNow(m_toggle, 22);
+    midi_out.sendCachedCCNow(r_toggle, 23);
+
+    // read all of the gate triggers at once
+    uint32_t triggered = gates.process(inputs);
+
+    // if the mod a or mod b trigger goes high, toggle the modifier param
+    bool moda_triggered = triggered & (1 << MODA_GATE_INPUT);
+    if (moda_triggered)
+      params[TOGGLE_MODA_PARAM].setValue(1.f);
+    bool modb_triggered = triggered & (1 << MODB_GATE_INPUT);
+    if (modb_triggered)
+      params[TOGGLE_MODB_PARAM].setValue(1.f);
 
     // toggle either modifier on or off
     int moda_toggle = (int) floor(params[TOGGLE_MODA_PARAM].getValue());
     if (moda_toggle) {
       // allow a 250ms grace period between button presses to prevent spam
       if (should_transition_to_state(0.25f, moda_toggle_grace_period)) {
-        midi_out.sendCachedCC(next_moda_toggle_value, 30);
+        midi_out.sendCachedCCNow(next_moda_toggle_value, 30);
         if (next_moda_toggle_value == 1)
           next_moda_toggle_value = 127;
         else
           next_moda_toggle_value = 1;
 
         // remember for next time how long it as been since the toggle was pressed
-        gettimeofday(&moda_toggle_grace_period, NULL);
+        moda_toggle_grace_period = curr_time;
       }
     }
     int modb_toggle = (int) floor(params[TOGGLE_MODB_PARAM].getValue());
     if (modb_toggle) {
       // allow a 250ms grace period between button presses to prevent spam
       if (should_transition_to_state(0.25f, modb_toggle_grace_period)) {
-        midi_out.sendCachedCC(next_modb_toggle_value, 31);
+        midi_out.sendCachedCCNow(next_modb_toggle_value, 31);
         if (next_modb_toggle_value == 1)
           next_modb_toggle_value = 127;
         else
           next_modb_toggle_value = 1;
 
         // remember for next time how long it as been since the toggle was pressed
-        gettimeofday(&modb_toggle_grace_period, NULL);
+        modb_toggle_grace_period = curr_time;
       }
     }
 
@@ -318,166 +231,30 @@ struct Blooper : RRModule {
     if (modb_triggered)
       params[TOGGLE_MODB_PARAM].setValue(0);
 
-    // check if the preset button was pressed (protect it from being spammed)
-    int loop_change_incr = (int) floor(params[LOOP_SELECT_INCR_PARAM].getValue());
-    int loop_change_decr = (int) floor(params[LOOP_SELECT_DECR_PARAM].getValue());
-
-    // only process the loop change if either button was pressed and we are not already
-    // performing a loop change request (bypass_state == 6)
-    if ((loop_change_incr || loop_change_decr) && bypass_state != 6) {
-      // allow a 1s grace period between loop changes
-      if (should_transition_to_state(1.0f, loop_select_grace_period)) {
-        // stop any existing loops before we do the loop change
-        stop();
-
-        // transition to state 6, wich means we are "loading a loop"
-        bypass_state = 6;
-
-        if (!program_change) {
-          // if we've never done a program change, jump straight to program 0
-          midi_out.setProgram(0);
-          program_change = true;
-        } else {
-          // increment or decrement by 1 the program
-          // with a max of 16 programs (loops).
-          if (loop_change_incr)
-            midi_out.incrementProgram(1, 16);
-          else
-            midi_out.decrementProgram(1, 16);
-        }
-
-        // remember for next time when we performed the loop change
-        gettimeofday(&loop_select_grace_period, NULL);
-      }
-    }
-
-    // ---------------------------
-    // -- Blooper State Machine --
-    // ---------------------------
-    //
-    // STATE 0: Pedal is in an UNKNOWN state
-    // STATE 1: (semi-transient) Pedal is in a RECORDING state
-    //    -- in reality it can only stay in this state for the
-    //       maximum loop duration supported by the pedal 32s.
-    //    -- Can be manually transitioned to STOPPED/PLAYING/ERASING states.
-    // STATE 2: Pedal is in a PLAYING state
-    // STATE 3: Pedal is in a STOPPED state
-    // STATE 4: (full-transient) Pedal is in an ERASING state.
-    //   -- Will transition automatically to a STOPPED state.
-    // STATE 5: (semi-transient) Pedal is undergoing a ONE SHOT Record
-    //   -- Will transition automatically to a PLAYING state.
-    //   -- Can be manually transitioned to STOPPED or ERASING.
-    // STATE 6: (full-transient) Pedal is in a LOOP_CHANGE state.
-    //   -- all messages are ignored for a hardcoded time to allow
-    //      the loop to be loaded. Will transition to a STOPPED state.
-
-    // toggle the lights based on the current state
-    if (bypass_state == 0) {
-      // pedal is not playing / unknown state
-      lights[LEFT_LIGHT + 0].setBrightness(0.f);
-      lights[LEFT_LIGHT + 1].setBrightness(0.f);
-      lights[RIGHT_LIGHT].setBrightness(0.f);
-      lights[RIGHT_LIGHT + 1].setBrightness(0.f);
-    } else if (bypass_state == 1) {
-      // recording, so light will be red
-      lights[LEFT_LIGHT].setBrightness(0.f);
-      lights[LEFT_LIGHT + 1].setBrightness(1.f);
-      lights[RIGHT_LIGHT].setBrightness(0.f);
-      lights[RIGHT_LIGHT + 1].setBrightness(0.f);
-    } else if (bypass_state == 2) {
-      // recording is playing, so light will be green
-      lights[LEFT_LIGHT].setBrightness(1.f);
-      lights[LEFT_LIGHT + 1].setBrightness(0.f);
-      lights[RIGHT_LIGHT].setBrightness(0.f);
-      lights[RIGHT_LIGHT + 1].setBrightness(0.f);
-    } else if (bypass_state == 3) {
-      // recording is stopped, so flash green
-      lights[LEFT_LIGHT].setBrightness(flash_led(0.50f));
-      lights[LEFT_LIGHT + 1].setBrightness(0.f);
-      lights[RIGHT_LIGHT].setBrightness(0.f);
-      lights[RIGHT_LIGHT + 1].setBrightness(0.f);
-    } else if (bypass_state == 4) {
-      // recording is being deleted, flash both lights red for 2s
-      lights[LEFT_LIGHT+1].setBrightness(flash_led(0.30f));
-      lights[RIGHT_LIGHT+1].setBrightness(flash_led(0.30f));
-
-      // turn off the green lights
-      lights[LEFT_LIGHT].setBrightness(0);
-      lights[RIGHT_LIGHT].setBrightness(0);
-
-      // if 2s has passed since we started deleting, transition to off state
-      if (should_transition_to_state(2.0f, erase_grace_period))
-        bypass_state = 0;
-    } else if (bypass_state == 5) {
-      // a one shot recording operation is in progress, flash the left led red for
-      // the duration of the one shot record
-      lights[LEFT_LIGHT+1].setBrightness(flash_led(0.20f));
-
-      // turn off the green light
-      lights[LEFT_LIGHT].setBrightness(0);
-
-      // ideally this should flash the led red for the full duration of the loop
-      // but we don't have that measurement right now (TODO)
-      // for now, just stay in this state for 3s
-      if (should_transition_to_state(3.0f, one_shot_grace_period)) {
-        // go straight to a 'playing' state after the one shot recording is done
-        bypass_state = 2;
-
-        // force disable one shot mode in case it is still on
-        reset_one_shot(true);
-      }
-    } else if (bypass_state == 6) {
-      // a loop select change is in progress, flash both leds green
-      // for 4 seconds and then transition to the stopped state
-
-      // turn off the red lights
-      lights[LEFT_LIGHT+1].setBrightness(0);
-      lights[RIGHT_LIGHT+1].setBrightness(0);
-
-      // flash both lights green
-      lights[LEFT_LIGHT].setBrightness(flash_led(0.30f));
-      lights[RIGHT_LIGHT].setBrightness(flash_led(0.30f));
-
-      // transition to the stopped state after 4.0 seconds
-      if (should_transition_to_state(4.0f, loop_select_grace_period)) {
-        bypass_state = 3;
-        // force disable one shot mode in case it is still on
-        reset_one_shot(true);
-      }
-    }
+    // the loop select buttons step through the loops
+    RRBlooperTransport::Buttons buttons;
+    if (params[LOOP_SELECT_INCR_PARAM].getValue() >= 1.f)
+      buttons.loop_select = 1;
+    else if (params[LOOP_SELECT_DECR_PARAM].getValue() >= 1.f)
+      buttons.loop_select = -1;
 
-    // read the gate triggers
-    bool stop_triggered = false;
-    if (inputs[STOP_GATE_INPUT].isConnected()) {
-      if (stop_gate_trigger.process(rescale(inputs[STOP_GATE_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, turn on on stop loop param
-        params[STOP_LOOP_PARAM].setValue(1.f);
-        stop_triggered = true;
-      }
-    }
-    bool play_triggered = false;
-    if (inputs[PLAY_GATE_INPUT].isConnected()) {
-      if (play_gate_trigger.process(rescale(inputs[PLAY_GATE_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, turn on on play loop param
-        params[PLAY_LOOP_PARAM].setValue(1.f);
-        play_triggered = true;
-      }
-    }
-    bool rec_triggered = false;
-    if (inputs[RECORD_GATE_INPUT].isConnected()) {
-      if (record_gate_trigger.process(rescale(inputs[RECORD_GATE_INPUT].getVoltage(), 0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, turn on on rec loop param
-        params[RECORD_LOOP_PARAM].setValue(1.f);
-        rec_triggered = true;
-      }
-    }
+    // if the stop, play or rec trigger goes high, turn on its loop param
+    bool stop_triggered = triggered & (1 << STOP_GATE_INPUT);
+    if (stop_triggered)
+      params[STOP_LOOP_PARAM].setValue(1.f);
+    bool play_triggered = triggered & (1 << PLAY_GATE_INPUT);
+    if (play_triggered)
+      params[PLAY_LOOP_PARAM].setValue(1.f);
+    bool rec_triggered = triggered & (1 << RECORD_GATE_INPUT);
+    if (rec_triggered)
+      params[RECORD_LOOP_PARAM].setValue(1.f);
 
     // read the bypass button values
-    int record_loop = (int) floor(params[RECORD_LOOP_PARAM].getValue());
-    int play_loop = (int) floor(params[PLAY_LOOP_PARAM].getValue());
-    int stop_loop = (int) floor(params[STOP_LOOP_PARAM].getValue());
-    int erase_loop = (int) floor(params[ERASE_LOOP_PARAM].getValue());
-    int one_shot = (int) floor(params[TOGGLE_ONE_SHOT_RECORD_PARAM].getValue());
+    buttons.record = params[RECORD_LOOP_PARAM].getValue() >= 1.f;
+    buttons.play = params[PLAY_LOOP_PARAM].getValue() >= 1.f;
+    buttons.stop = params[STOP_LOOP_PARAM].getValue() >= 1.f;
+    buttons.erase = params[ERASE_LOOP_PARAM].getValue() >= 1.f;
+    buttons.one_shot = params[TOGGLE_ONE_SHOT_RECORD_PARAM].getValue() >= 1.f;
 
     // turn off the triggers if they are on
     if (stop_triggered)
@@ -487,183 +264,80 @@ struct Blooper : RRModule {
     if (rec_triggered)
       params[RECORD_LOOP_PARAM].setValue(0);
 
-    // first things first, disable one_shot record if it was not turned on
-    // don't reset the cache
-    if (one_shot == 0)
-      reset_one_shot(false);
-
-    // State transitions:
-    // 1) first press of record makes pedal record
-    //    and left led lights changes from off to red
-    // 2) play makes pedal play
-    //    and left led lights changes from red to green
-    // 3) pressing stop during play states, makes loop stop
-    //    and left led changes from green to flashing green (200ms flashes)
-    // 4) pressing record while in play state will allow for overdubs
-    //    and left led lights changes from green to red
-    // 5) performing a record or overdub with one shot enabled will
-    //    issue an overdab that lasts as long as the original loop.
-
-    if (bypass_state == 0) {
-       // pedal state is unknown, need to assume all state transitions are possible.
-      if (record_loop) {
-        // TODO:
-        // the length of the first recording, i.e. the time between pressing record and play
-        // dictates how often the modifier lights flash. We should calculate this so that
-        // we can predict how long a one shot recording should take
-        if (one_shot) {
-          // requested to do a one shot record
-          bypass_state = 5;
-          one_shot_record();
-        } else {
-          // requested to turn on record
-          bypass_state = 1;
-          record();
-        }
-      } else if (play_loop) {
-        bypass_state = 2;
-        play();
-      } else if (stop_loop) {
-        bypass_state = 3;
-        stop();
-      } else if (erase_loop) {
-        // requested to erase the loop
-        bypass_state = 4;
-        erase();
-      }
-    } else if (bypass_state == 1) {
-      // pedal is recording
-      if (play_loop) {
-        // requested to play the loop
-        bypass_state = 2;
-        play();
-      } else if (stop_loop) {
-        // requested to stop the loop
-        bypass_state = 3;
-        stop();
-      } else if (erase_loop) {
-        // requested to erase the loop
-        bypass_state = 4;
-        erase();
-      }
-    } else if (bypass_state == 2) {
-      // pedal is playing
-      if (record_loop) {
-        if (one_shot) {
-          // requested to do a one shot record
-          bypass_state = 5;
-          one_shot_record();
-        } else {
-          // requested to overdub something
-          bypass_state = 1;
-          over_dub();
-        }
-      } else if (stop_loop) {
-        // requested to stop the loop
-        bypass_state = 3;
-        stop();
-      } else if (erase_loop) {
-        // requested to erase the loop
-        bypass_state = 4;
-        erase();
-      }
-    } else if (bypass_state == 3) {
-      // pedal is stopped
-      if (play_loop) {
-        // requested to play the loop
-        bypass_state = 2;
-        play();
-      } else if (stop_loop) {
-        // requested to stop the loop
-        bypass_state = 3;
-        stop();
-      } else if (erase_loop) {
-        // requested to erase the loop
-        bypass_state = 4;
-        erase();
-      }
-    } else if (bypass_state == 4) {
-      // transient state, loop is being erased
-      // ignore all state change requests until we transition to
-      // the off state.
-    } else if (bypass_state == 5) {
-      // transient state, currently processing a one-shot record
-      // ignore all state changes except for stop and erase state changes
-      if (stop_loop) {
-        // requested to stop the loop or abort the one shot record
-        bypass_state = 3;
-        stop();
-      } else if (erase_loop) {
-        bypass_state = 4;
-        erase();
-      }
-    } else if (bypass_state == 6) {
-      // transiet state, a loop change is in progress
-      // ignore all state change requests until we complete the transition
-      // to the stopped state.
+    // run the transport
+    transport.process(&midi_out, buttons, curr_time);
+
+    // toggle the lights based on the current state
+    switch (transport.state) {
+      case RRBlooperTransport::UNKNOWN:
+        // pedal is not playing / unknown state
+        lights[LEFT_LIGHT + 0].setBrightness(0.f);
+        lights[LEFT_LIGHT + 1].setBrightness(0.f);
+        lights[RIGHT_LIGHT].setBrightness(0.f);
+        lights[RIGHT_LIGHT + 1].setBrightness(0.f);
+        break;
+      case RRBlooperTransport::RECORDING:
+        // recording, so light will be red
+        lights[LEFT_LIGHT].setBrightness(0.f);
+        lights[LEFT_LIGHT + 1].setBrightness(1.f);
+        lights[RIGHT_LIGHT].setBrightness(0.f);
+        lights[RIGHT_LIGHT + 1].setBrightness(0.f);
+        break;
+      case RRBlooperTransport::PLAYING:
+        // recording is playing, so light will be green
+        lights[LEFT_LIGHT].setBrightness(1.f);
+        lights[LEFT_LIGHT + 1].setBrightness(0.f);
+        lights[RIGHT_LIGHT].setBrightness(0.f);
+        lights[RIGHT_LIGHT + 1].setBrightness(0.f);
+        break;
+      case RRBlooperTransport::STOPPED:
+        // recording is stopped, so flash green
+        lights[LEFT_LIGHT].setBrightness(flash_led(0.50f));
+        lights[LEFT_LIGHT + 1].setBrightness(0.f);
+        lights[RIGHT_LIGHT].setBrightness(0.f);
+        lights[RIGHT_LIGHT + 1].setBrightness(0.f);
+        break;
+      case RRBlooperTransport::ERASING:
+        // recording is being deleted, flash both lights red
+        lights[LEFT_LIGHT+1].setBrightness(flash_led(0.30f));
+        lights[RIGHT_LIGHT+1].setBrightness(flash_led(0.30f));
+
+        // turn off the green lights
+        lights[LEFT_LIGHT].setBrightness(0);
+        lights[RIGHT_LIGHT].setBrightness(0);
+        break;
+      case RRBlooperTransport::ONE_SHOT:
+        // a one shot recording operation is in progress, flash the left led red for
+        // the duration of the one shot record
+        lights[LEFT_LIGHT+1].setBrightness(flash_led(0.20f));
+
+        // turn off the green light
+        lights[LEFT_LIGHT].setBrightness(0);
+        break;
+      case RRBlooperTransport::LOOP_CHANGE:
+        // a loop select change is in progress, flash both leds green
+
+        // turn off the red lights
+        lights[LEFT_LIGHT+1].setBrightness(0);
+        lights[RIGHT_LIGHT+1].setBrightness(0);
+
+        // flash both lights green
+        lights[LEFT_LIGHT].setBrightness(flash_led(0.30f));
+        lights[RIGHT_LIGHT].setBrightness(flash_led(0.30f));
+        break;
     }
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs
     // or aggressive knob operations by the user.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int volume = (int) std::round(params[VOLUME_PARAM].getValue());
-    int layers = (int) std::round(params[LAYERS_PARAM].getValue());
-    int repeats = (int) std::round(params[REPEATS_PARAM].getValue());
-    int moda = (int) std::round(params[MODA_PARAM].getValue());
-    int stability = (int) std::round(params[STABILITY_PARAM].getValue());
-    int modb = (int) std::round(params[MODB_PARAM].getValue());
-    int ramp = (int) std::round(params[RAMP_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs, use the knob value as a ceiling
-    if (inputs[VOLUME_INPUT].isConnected()) {
-      int volume_cv = convertCVtoCC(inputs[VOLUME_INPUT].getVoltage());
-      volume = clamp(volume_cv, 0, volume);
-    }
-    if (inputs[LAYERS_INPUT].isConnected()) {
-      int layers_cv = convertCVtoCC(inputs[LAYERS_INPUT].getVoltage());
-      layers = clamp(layers_cv, 0, layers);
-    }
-    if (inputs[REPEATS_INPUT].isConnected()) {
-      int repeats_cv = convertCVtoCC(inputs[REPEATS_INPUT].getVoltage());
-      repeats = clamp(repeats_cv, 0, repeats);
-    }
-    if (inputs[MODA_INPUT].isConnected()) {
-      int moda_cv = convertCVtoCC(inputs[MODA_INPUT].getVoltage());
-      moda = clamp(moda_cv, 0, moda);
-    }
-    if (inputs[STABILITY_INPUT].isConnected()) {
-      int stability_cv = convertCVtoCC(inputs[STABILITY_INPUT].getVoltage());
-      stability = clamp(stability_cv, 0, stability);
-    }
-    if (inputs[MODB_INPUT].isConnected()) {
-      int modb_cv = convertCVtoCC(inputs[MODB_INPUT].getVoltage());
-      modb = clamp(modb_cv, 0, modb);
-    }
-    if (inputs[RAMP_INPUT].isConnected()) {
-      int ramp_cv = convertCVtoCC(inputs[RAMP_INPUT].getVoltage());
-      ramp = clamp(ramp_cv, 0, 127);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(volume, 14);
-    midi_out.sendCachedCC(layers, 15);
-    midi_out.sendCachedCC(repeats, 16);
-    midi_out.sendCachedCC(moda, 17);
-    midi_out.sendCachedCC(stability, 18);
-    midi_out.sendCachedCC(modb, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
 
     // assign value for ramping only if ramping is turned on
     int enable_ramp = (int) floor(params[TOGGLE_RAMP_PARAM].getValue());
@@ -671,18 +345,27 @@ struct Blooper : RRModule {
       // turn on ramping
       midi_out.sendCachedCC(1, 52);
 
-      // set the current ramp value
+      // set the current ramp value, the cv overrides the knob
+      int ramp = (int) std::round(params[RAMP_PARAM].getValue());
+      if (inputs[RAMP_INPUT].isConnected())
+        ramp = hold_cv_cc(decimated_cv(RAMP_INPUT), 20);
       midi_out.sendCachedCC(ramp, 20);
     } else {
       // turn off ramping
       midi_out.sendCachedCC(0, 52);
     }
 
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
+
     return;
   }
 };
 
-struct BlooperWidget : ModuleWidget {
+constexpr RRKnobCC Blooper::KNOBS[];
+
+struct BlooperWidget : RRModuleWidget {
   BlooperWidget(Blooper* module) {
     setModule(module);
 
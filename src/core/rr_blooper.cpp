@@ -0,0 +1,239 @@
+#include "rr_blooper.hpp"
+
+constexpr double RRBlooperTransport::ERASE_TIME;
+constexpr double RRBlooperTransport::ONE_SHOT_TIME;
+constexpr double RRBlooperTransport::LOOP_CHANGE_TIME;
+constexpr double RRBlooperTransport::LOOP_SELECT_GRACE;
+
+void RRBlooperTransport::process(RRCCCache* out, const Buttons& buttons, double now) {
+  // only process the loop change if either button was pressed and we are not already
+  // performing a loop change request
+  if (buttons.loop_select && state != LOOP_CHANGE) {
+    // allow a 1s grace period between loop changes
+    if (now - loop_select_time > LOOP_SELECT_GRACE)
+      select_loop(out, buttons.loop_select, now);
+  }
+
+  // the transient states time out
+  if (state == ERASING) {
+    // if 2s has passed since we started deleting, transition to off state
+    if (now - erase_time > ERASE_TIME)
+      state = UNKNOWN;
+  } else if (state == ONE_SHOT) {
+    if (now - one_shot_time > ONE_SHOT_TIME) {
+      // go straight to a 'playing' state after the one shot recording is done
+      state = PLAYING;
+
+      // force disable one shot mode in case it is still on
+      reset_one_shot(out, true);
+    }
+  } else if (state == LOOP_CHANGE) {
+    // transition to the stopped state once the loop is loaded
+    if (now - loop_select_time > LOOP_CHANGE_TIME) {
+      state = STOPPED;
+      // force disable one shot mode in case it is still on
+      reset_one_shot(out, true);
+    }
+  }
+
+  // first things first, disable one_shot record if it was not turned on
+  // don't reset the cache
+  if (!buttons.one_shot)
+    reset_one_shot(out, false);
+
+  // State transitions:
+  // 1) first press of record makes pedal record
+  //    and left led lights changes from off to red
+  // 2) play makes pedal play
+  //    and left led lights changes from red to green
+  // 3) pressing stop during play states, makes loop stop
+  //    and left led changes from green to flashing green (200ms flashes)
+  // 4) pressing record while in play state will allow for overdubs
+  //    and left led lights changes from green to red
+  // 5) performing a record or overdub with one shot enabled will
+  //    issue an overdab that lasts as long as the original loop.
+
+  if (state == UNKNOWN) {
+    // pedal state is unknown, need to assume all state transitions are possible.
+    if (buttons.record) {
+      // TODO:
+      // the length of the first recording, i.e. the time between pressing record and play
+      // dictates how often the modifier lights flash. We should calculate this so that
+      // we can predict how long a one shot recording should take
+      if (buttons.one_shot) {
+        // requested to do a one shot record
+        state = ONE_SHOT;
+        one_shot_record(out, now);
+      } else {
+        // requested to turn on record
+        state = RECORDING;
+        record(out);
+      }
+    } else if (buttons.play) {
+      state = PLAYING;
+      play(out);
+    } else if (buttons.stop) {
+      state = STOPPED;
+      stop(out);
+    } else if (buttons.erase) {
+      // requested to erase the loop
+      state = ERASING;
+      erase(out, now);
+    }
+  } else if (state == RECORDING) {
+    // pedal is recording
+    if (buttons.play) {
+      // requested to play the loop
+      state = PLAYING;
+      play(out);
+    } else if (buttons.stop) {
+      // requested to stop the loop
+      state = STOPPED;
+      stop(out);
+    } else if (buttons.erase) {
+      // requested to erase the loop
+      state = ERASING;
+      erase(out, now);
+    }
+  } else if (state == PLAYING) {
+    // pedal is playing
+    if (buttons.record) {
+      if (buttons.one_shot) {
+        // requested to do a one shot record
+        state = ONE_SHOT;
+        one_shot_record(out, now);
+      } else {
+        // requested to overdub something
+        state = RECORDING;
+        over_dub(out);
+      }
+    } else if (buttons.stop) {
+      // requested to stop the loop
+      state = STOPPED;
+      stop(out);
+    } else if (buttons.erase) {
+      // requested to erase the loop
+      state = ERASING;
+      erase(out, now);
+    }
+  } else if (state == STOPPED) {
+    // pedal is stopped
+    if (buttons.play) {
+      // requested to play the loop
+      state = PLAYING;
+      play(out);
+    } else if (buttons.stop) {
+      // requested to stop the loop
+      state = STOPPED;
+      stop(out);
+    } else if (buttons.erase) {
+      // requested to erase the loop
+      state = ERASING;
+      erase(out, now);
+    }
+  } else if (state == ERASING) {
+    // transient state, loop is being erased
+    // ignore all state change requests until we transition to
+    // the off state.
+  } else if (state == ONE_SHOT) {
+    // transient state, currently processing a one-shot record
+    // ignore all state changes except for stop and erase state changes
+    if (buttons.stop) {
+      // requested to stop the loop or abort the one shot record
+      state = STOPPED;
+      stop(out);
+    } else if (buttons.erase) {
+      state = ERASING;
+      erase(out, now);
+    }
+  } else if (state == LOOP_CHANGE) {
+    // transiet state, a loop change is in progress
+    // ignore all state change requests until we complete the transition
+    // to the stopped state.
+  }
+}
+
+// the transport commands go out right away (CC 11), they must not be
+// coalesced with the knobs
+
+void RRBlooperTransport::record(RRCCCache* out) {
+  // disable one shot record
+  reset_one_shot(out, false);
+
+  // send a record message
+  out->sendCachedCCNow(1, 11);
+}
+
+void RRBlooperTransport::play(RRCCCache* out) {
+  // disable one shot record
+  reset_one_shot(out, false);
+
+  // send a play message
+  out->sendCachedCCNow(2, 11);
+}
+
+void RRBlooperTransport::over_dub(RRCCCache* out) {
+  // disable one shot record
+  reset_one_shot(out, false);
+
+  // send an over dub message
+  out->sendCachedCCNow(3, 11);
+}
+
+void RRBlooperTransport::stop(RRCCCache* out) {
+  // disable one shot record
+  reset_one_shot(out, false);
+
+  // send a stop message
+  out->sendCachedCCNow(4, 11);
+}
+
+void RRBlooperTransport::erase(RRCCCache* out, double now) {
+  // disable one shot record
+  reset_one_shot(out, false);
+
+  // send an erase message
+  out->sendCachedCCNow(7, 11);
+
+  // collect a timestamp to know when the
+  // erase grace period starts
+  erase_time = now;
+}
+
+void RRBlooperTransport::one_shot_record(RRCCCache* out, double now) {
+  // enable one shot record
+  out->sendCachedCCNow(1, 9);
+
+  // collect a timestamp to know when the one shot grace period starts
+  one_shot_time = now;
+}
+
+void RRBlooperTransport::reset_one_shot(RRCCCache* out, bool reset_cache) {
+  if (reset_cache)
+    out->resetCCCache(9);
+  out->sendCachedCCNow(0, 9);
+}
+
+void RRBlooperTransport::select_loop(RRCCCache* out, int direction, double now) {
+  // stop any existing loops before we do the loop change
+  stop(out);
+
+  // transition to the loop change state, wich means we are "loading a loop"
+  state = LOOP_CHANGE;
+
+  if (!program_change) {
+    // if we've never done a program change, jump straight to program 0
+    out->setProgram(0);
+    program_change = true;
+  } else {
+    // increment or decrement by 1 the program
+    // with a max of 16 programs (loops).
+    if (direction > 0)
+      out->incrementProgram(1, NUM_LOOPS);
+    else
+      out->decrementProgram(1, NUM_LOOPS);
+  }
+
+  // remember for next time when we performed the loop change
+  loop_select_time = now;
+}
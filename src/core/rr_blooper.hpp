@@ -0,0 +1,85 @@
+#pragma once
+
+#include "rr_cc.hpp"
+
+// the Blooper's transport (record, play, overdub, stop, erase, one shot
+// record and loop selection). it follows the state the pedal is in and
+// sends the commands through the CC cache. nothing in here depends on
+// Rack, the module drives it with its own monotonic timebase (in seconds).
+//
+// STATE 0: Pedal is in an UNKNOWN state
+// STATE 1: (semi-transient) Pedal is in a RECORDING state
+//    -- in reality it can only stay in this state for the
+//       maximum loop duration supported by the pedal 32s.
+//    -- Can be manually transitioned to STOPPED/PLAYING/ERASING states.
+// STATE 2: Pedal is in a PLAYING state
+// STATE 3: Pedal is in a STOPPED state
+// STATE 4: (full-transient) Pedal is in an ERASING state.
+//   -- Will transition automatically to a STOPPED state.
+// STATE 5: (semi-transient) Pedal is undergoing a ONE SHOT Record
+//   -- Will transition automatically to a PLAYING state.
+//   -- Can be manually transitioned to STOPPED or ERASING.
+// STATE 6: (full-transient) Pedal is in a LOOP_CHANGE state.
+//   -- all messages are ignored for a hardcoded time to allow
+//      the loop to be loaded. Will transition to a STOPPED state.
+struct RRBlooperTransport {
+  enum States {
+    UNKNOWN,
+    RECORDING,
+    PLAYING,
+    STOPPED,
+    ERASING,
+    ONE_SHOT,
+    LOOP_CHANGE
+  };
+
+  // how long the transient states last (seconds)
+  static constexpr double ERASE_TIME = 2.0;
+  // ideally this would be the length of the loop, but we don't
+  // have that measurement right now (TODO)
+  static constexpr double ONE_SHOT_TIME = 3.0;
+  static constexpr double LOOP_CHANGE_TIME = 4.0;
+  // grace period between loop changes
+  static constexpr double LOOP_SELECT_GRACE = 1.0;
+  // loop slots of the pedal
+  static const int NUM_LOOPS = 16;
+
+  // the buttons (or gates) pressed during this sample
+  struct Buttons {
+    bool record = false;
+    bool play = false;
+    bool stop = false;
+    bool erase = false;
+    // one shot record is switched on
+    bool one_shot = false;
+    // +1 (next loop), -1 (previous loop) or 0
+    int loop_select = 0;
+  };
+
+  int state = UNKNOWN;
+
+  // no loop was selected yet, the first loop change goes to loop 0
+  bool program_change = false;
+
+  // when the timed states started (timebase seconds)
+  double erase_time = 0.0;
+  double one_shot_time = 0.0;
+  double loop_select_time = 0.0;
+
+  // advances the transport by one sample
+  void process(RRCCCache* out, const Buttons& buttons, double now);
+
+  // the transient states flash the LEDs and time out on their own
+  bool timers_running() {
+    return state > PLAYING;
+  }
+
+  void record(RRCCCache* out);
+  void play(RRCCCache* out);
+  void over_dub(RRCCCache* out);
+  void stop(RRCCCache* out);
+  void erase(RRCCCache* out, double now);
+  void one_shot_record(RRCCCache* out, double now);
+  void reset_one_shot(RRCCCache* out, bool reset_cache);
+  void select_loop(RRCCCache* out, int direction, double now);
+};
@@ -0,0 +1,118 @@
+#include "rr_bytestream.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// printf into a std::string, for the reports
+template <typename... Args>
+static std::string format(const char* fmt, Args... args) {
+  char buf[128];
+  snprintf(buf, sizeof(buf), fmt, args...);
+  return buf;
+}
+
+void RRByteStream::add(int64_t frame, const uint8_t* bytes, int size) {
+  RRByteEvent event;
+  event.frame = frame;
+  event.size = size;
+  for (int i = 0; i < size; i++)
+    event.bytes[i] = bytes[i];
+  events.push_back(event);
+}
+
+bool RRByteStream::save(const std::string& path) const {
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+
+  fprintf(file, "# RobRichards byte stream\n");
+  fprintf(file, "samplerate %.0f\n", sampleRate);
+  for (size_t i = 0; i < events.size(); i++) {
+    fprintf(file, "%lld", (long long) getFrame(i));
+    for (int j = 0; j < events[i].size; j++)
+      fprintf(file, " %02x", events[i].bytes[j]);
+    fprintf(file, "\n");
+  }
+  fclose(file);
+  return true;
+}
+
+bool RRByteStream::load(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file)
+    return false;
+
+  clear();
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#')
+      continue;
+
+    float rate;
+    if (sscanf(line, "samplerate %f", &rate) == 1) {
+      sampleRate = rate;
+      continue;
+    }
+
+    long long frame;
+    unsigned int bytes[3];
+    int n = sscanf(line, "%lld %x %x %x", &frame, &bytes[0], &bytes[1], &bytes[2]);
+    if (n < 2)
+      continue;
+
+    RRByteEvent event;
+    event.frame = frame;
+    event.size = n - 1;
+    for (int i = 0; i < event.size; i++)
+      event.bytes[i] = bytes[i];
+    events.push_back(event);
+  }
+  fclose(file);
+  return sampleRate > 0.f;
+}
+
+bool RRByteStream::compare(const RRByteStream& golden, double tolerance, std::string* report) const {
+  // the frames only mean the same at the same sample rate
+  bool exact = tolerance <= 0.0;
+  if (exact && sampleRate != golden.sampleRate) {
+    *report = format("sample rate %.0f, golden has %.0f", sampleRate, golden.sampleRate);
+    return false;
+  }
+
+  size_t count = std::min(events.size(), golden.events.size());
+  for (size_t i = 0; i < count; i++) {
+    const RRByteEvent& a = events[i];
+    const RRByteEvent& b = golden.events[i];
+
+    bool same = a.size == b.size;
+    for (int j = 0; same && j < a.size; j++)
+      same = a.bytes[j] == b.bytes[j];
+    if (!same) {
+      *report = format("message %d: bytes differ", (int) i + 1);
+      return false;
+    }
+
+    if (exact) {
+      if (getFrame(i) != golden.getFrame(i)) {
+        *report = format("message %d: frame %lld, golden has %lld", (int) i + 1,
+          (long long) getFrame(i), (long long) golden.getFrame(i));
+        return false;
+      }
+      continue;
+    }
+
+    double drift = getTime(i) - golden.getTime(i);
+    if (std::fabs(drift) > tolerance) {
+      *report = format("message %d: %+.1f ms off", (int) i + 1, drift * 1000);
+      return false;
+    }
+  }
+
+  if (events.size() != golden.events.size()) {
+    *report = format("%d messages, golden has %d", (int) events.size(), (int) golden.events.size());
+    return false;
+  }
+
+  *report = format("match (%d messages)", (int) events.size());
+  return true;
+}
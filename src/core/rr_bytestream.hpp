@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// a recorded MIDI byte stream, saved as a "golden" text file:
+//
+//   # RobRichards byte stream
+//   samplerate 48000
+//   <frames since the first message> <status> <data1> <data2>
+//
+// the frames are the ones the messages were generated on, so the timing
+// doesn't depend on how busy the machine was while recording. the pedal
+// emulator records them in Rack, the scenario drivers (test/golden)
+// without it.
+
+struct RRByteEvent {
+  // engine frame the message was generated on
+  int64_t frame;
+  uint8_t bytes[3];
+  uint8_t size;
+};
+
+struct RRByteStream {
+  float sampleRate = 0.f;
+  std::vector<RRByteEvent> events;
+
+  void clear() {
+    events.clear();
+  }
+
+  void add(int64_t frame, const uint8_t* bytes, int size);
+
+  // frames since the first message
+  int64_t getFrame(size_t i) const {
+    return events[i].frame - events[0].frame;
+  }
+
+  double getTime(size_t i) const {
+    if (events.empty() || sampleRate <= 0.f)
+      return 0.0;
+    return getFrame(i) / (double) sampleRate;
+  }
+
+  bool save(const std::string& path) const;
+  bool load(const std::string& path);
+
+  // compares the stream with the golden one, the bytes have to match
+  // exactly and the timing within the tolerance (seconds). without a
+  // tolerance the frames have to match exactly too. the report says
+  // where they differ first.
+  bool compare(const RRByteStream& golden, double tolerance, std::string* report) const;
+};
@@ -0,0 +1,208 @@
+#include "rr_cc.hpp"
+
+RRCCCache::RRCCCache() {
+  resetCache();
+  for (int n = 0; n < 128; n++)
+    lowResCCs[n] = false;
+}
+
+void RRCCCache::resetCache() {
+  // clean up the cache of CC values
+  for (int n = 0; n < 128; n++) {
+    lastMidiCCValues[n] = -1;
+    pendingMidiCCValues[n] = -1;
+    pendingMidiCCDummy[n] = false;
+    pendingMidiCCHiRes[n] = false;
+    pendingListed[n] = false;
+  }
+  numPendingCCs = 0;
+  cacheVersion++;
+}
+
+void RRCCCache::resetCCCache(int cc) {
+  if (lastMidiCCValues[cc] != -1) {
+    lastMidiCCValues[cc] = -1;
+    cacheVersion++;
+  }
+}
+
+bool RRCCCache::sendCachedCCNow(int value, int cc, bool dummy) {
+  lowResCCs[cc] = true;
+
+  // this value supersedes whatever is still staged
+  pendingMidiCCValues[cc] = -1;
+
+  // check the cache to see if we've already sent the same value
+  if (value == lastMidiCCValues[cc])
+    return false;
+  lastMidiCCValues[cc] = value;
+  enqueue(0xb0, cc, value, 3, dummy);
+  return true;
+}
+
+bool RRCCCache::sendCachedCC14(int value, int cc) {
+  // the LSB needs a free CC n+32, fall back to 7 bits otherwise
+  if (!highResCCs || cc >= 32 || lowResCCs[cc + 32])
+    return stageCC((value * 127 + 8191) / 16383, cc, true);
+  return stageCC14(value, cc, true);
+}
+
+bool RRCCCache::stageCC14(int value, int cc, bool dummy) {
+  // check the cache (staged value first, then the wire value)
+  int curr_value = -1;
+  if (pendingMidiCCValues[cc] >= 0) {
+    if (pendingMidiCCHiRes[cc])
+      curr_value = pendingMidiCCValues[cc];
+  } else if (lastMidiCCValues[cc] >= 0 && lastMidiCCValues[cc + 32] >= 0) {
+    curr_value = (lastMidiCCValues[cc] << 7) | lastMidiCCValues[cc + 32];
+  }
+  if (value == curr_value) {
+    return false;
+  }
+
+  // remember the order in which the CCs were first staged
+  if (!pendingListed[cc]) {
+    pendingListed[cc] = true;
+    pendingCCs[numPendingCCs++] = cc;
+  }
+  pendingMidiCCValues[cc] = value;
+  pendingMidiCCDummy[cc] = dummy;
+  pendingMidiCCHiRes[cc] = true;
+  return true;
+}
+
+bool RRCCCache::stageCC(int value, int cc, bool dummy) {
+  lowResCCs[cc] = true;
+
+  // check the cache (staged value first, then the wire value)
+  int curr_value = pendingMidiCCValues[cc];
+  if (curr_value < 0)
+    curr_value = lastMidiCCValues[cc];
+  if (value == curr_value) {
+    return false;
+  }
+
+  // remember the order in which the CCs were first staged
+  if (!pendingListed[cc]) {
+    pendingListed[cc] = true;
+    pendingCCs[numPendingCCs++] = cc;
+  }
+  pendingMidiCCValues[cc] = value;
+  pendingMidiCCDummy[cc] = dummy;
+  pendingMidiCCHiRes[cc] = false;
+  return true;
+}
+
+void RRCCCache::flushCachedCC14(int value, int cc) {
+  int msb = value >> 7;
+  int lsb = value & 0x7f;
+
+  // a new MSB clears the LSB on the receiving end
+  bool send_msb = msb != lastMidiCCValues[cc];
+  int wire_lsb = send_msb ? 0 : lastMidiCCValues[cc + 32];
+  bool send_lsb = lsb != wire_lsb;
+  lastMidiCCValues[cc] = msb;
+  lastMidiCCValues[cc + 32] = lsb;
+
+  // only send the LSB when it changed
+  if (send_msb)
+    enqueue(0xb0, cc, msb, 3, pendingMidiCCDummy[cc], send_lsb ? lsb : -1);
+  else if (send_lsb)
+    enqueue(0xb0, cc + 32, lsb, 3, pendingMidiCCDummy[cc]);
+}
+
+void RRCCCache::flushCachedCCs() {
+  for (int i = 0; i < numPendingCCs; i++) {
+    int cc = pendingCCs[i];
+    int value = pendingMidiCCValues[cc];
+    pendingMidiCCValues[cc] = -1;
+    pendingListed[cc] = false;
+
+    // the staged value was dropped
+    if (value < 0)
+      continue;
+
+    if (pendingMidiCCHiRes[cc]) {
+      flushCachedCC14(value, cc);
+      continue;
+    }
+
+    // the value may have returned to what is already on the wire
+    if (value == lastMidiCCValues[cc])
+      continue;
+    lastMidiCCValues[cc] = value;
+
+    // send the CC midi message, followed up with a dummy
+    // message when asked for
+    enqueue(0xb0, cc, value, 3, pendingMidiCCDummy[cc]);
+  }
+  numPendingCCs = 0;
+}
+
+void RRCCCache::incrementProgram(int incrby, int max) {
+  // incr the current program modded by the upper limit
+  if (currProgram == max)
+    currProgram = 0;
+  int value = (currProgram + incrby) % max;
+  setProgram(value);
+}
+
+void RRCCCache::decrementProgram(int decrby, int max) {
+  // decr the current program modded by the upper limit
+  if (currProgram == 0)
+    currProgram = max;
+  int value = (currProgram - decrby) % max;
+  setProgram(value);
+}
+
+bool RRCCCache::setProgram(int value) {
+  // check the cache to see if we are already on this program
+  if (currProgram == value) {
+    return false;
+  } else {
+    currProgram = value;
+  }
+
+  // anything staged before the program change has to go out first
+  flushCachedCCs();
+
+  // send a Program change message (2 bytes) with -
+  // 0x0c as the status byte
+  enqueue(0xc0, value, 0, 2);
+  return true;
+}
+
+constexpr float RRCCThinner::MAX_DEVIATION;
+constexpr double RRCCThinner::SETTLE_TIME;
+
+bool RRCCThinner::should_send(double time, float value, float error, bool force) {
+  if (value != last_value) {
+    last_value = value;
+    last_change_time = time;
+  }
+
+  // nothing new since the last sent value
+  if (!force && num_sent > 0 && value == sent_value[1]) {
+    pending = false;
+    return false;
+  }
+
+  bool resting = time - last_change_time >= SETTLE_TIME;
+  if (!force && num_sent >= 2 && !resting && sent_time[1] > sent_time[0]) {
+    float slope = (sent_value[1] - sent_value[0]) / (sent_time[1] - sent_time[0]);
+    float predicted = sent_value[1] + slope * (time - sent_time[1]);
+    if (std::fabs(value - predicted) <= error && std::fabs(value - sent_value[1]) <= MAX_DEVIATION) {
+      pending = true;
+      return false;
+    }
+  }
+
+  sent_time[0] = sent_time[1];
+  sent_value[0] = sent_value[1];
+  sent_time[1] = time;
+  sent_value[1] = value;
+  if (num_sent < 2)
+    num_sent++;
+  pending = false;
+  return true;
+}
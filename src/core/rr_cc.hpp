@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// CC handling of the pedals. nothing in here depends on Rack, the
+// output that puts the messages on the wire implements enqueue().
+
+// cache of the CC values on the wire plus a staging table. writes made
+// during a control block are coalesced (last value wins) and only go out
+// when the block is flushed with flushCachedCCs().
+struct RRCCCache {
+  // last CC values that went out on the wire
+  int lastMidiCCValues[128];
+
+  // send knobs as 14-bit CCs (MSB on CC n, LSB on CC n+32)
+  bool highResCCs = false;
+  // CCs that are sent as plain 7-bit CCs, they can't be used as an LSB
+  bool lowResCCs[128];
+
+  // staging table for cached CC messages
+  int pendingMidiCCValues[128];
+  bool pendingMidiCCDummy[128];
+  // the staged value is a 14-bit value
+  bool pendingMidiCCHiRes[128];
+  uint8_t pendingCCs[128];
+  // the CC is in pendingCCs (its staged value may have been dropped since)
+  bool pendingListed[128];
+  int numPendingCCs;
+
+  // bumped whenever cached values are dropped and need to be sent again
+  uint32_t cacheVersion = 0;
+
+  // program (preset, loop slot) the pedal is on, -1 if unknown
+  int currProgram = -1;
+
+  RRCCCache();
+  virtual ~RRCCCache() {}
+
+  // hands one message to the wire, followed up with a dummy message
+  // and/or the LSB (CC n+32) of a 14-bit CC when asked for
+  virtual void enqueue(uint8_t status, uint8_t data1, uint8_t data2, uint8_t size, bool dummy = false, int lsb = -1) = 0;
+
+  void resetCache();
+  void resetCCCache(int cc);
+
+  // the CC (n+32) carries the LSB of a 14-bit knob on CC n
+  bool isLSB(int cc) {
+    return highResCCs && cc >= 32 && cc < 64 && !lowResCCs[cc];
+  }
+
+  int getCachedCCValue(int cc) {
+    return lastMidiCCValues[cc];
+  }
+
+  bool sendCachedCC(int value, int cc) {
+    // stage the CC message, it will be followed up with a dummy message
+    return stageCC(value, cc, true);
+  }
+
+  bool sendCachedCCNoDummy(int value, int cc) {
+    // stage the CC message without a dummy message
+    return stageCC(value, cc, false);
+  }
+
+  // sends the CC right away, bypassing the staging table. for commands
+  // (transport, toggles) that must not be coalesced with the knobs.
+  bool sendCachedCCNow(int value, int cc, bool dummy = true);
+
+  bool sendCachedCC14(int value, int cc);
+  bool stageCC14(int value, int cc, bool dummy);
+  bool stageCC(int value, int cc, bool dummy);
+  void flushCachedCC14(int value, int cc);
+  void flushCachedCCs();
+
+  bool setProgram(int value);
+  void incrementProgram(int incrby, int max);
+  void decrementProgram(int decrby, int max);
+};
+
+// error-bounded thinning of a continuous CC. a new value only goes out when
+// linear extrapolation from the last two sent points misses it by more than
+// the error, when it drifted too far from the last sent value, or once the
+// control came to rest. the pedal's own smoothing fills in the rest.
+struct RRCCThinner {
+  // how far (in CC steps) the pedal may lag behind a moving control
+  static constexpr float MAX_DEVIATION = 8.f;
+  // how long (in seconds) a control has to hold still to count as at rest
+  static constexpr double SETTLE_TIME = 0.05;
+
+  double sent_time[2] = {0.0, 0.0};
+  float sent_value[2] = {0.f, 0.f};
+  int num_sent = 0;
+  float last_value = NAN;
+  double last_change_time = 0.0;
+  // a value was held back and still has to go out once the control rests
+  bool pending = false;
+
+  bool should_send(double time, float value, float error, bool force);
+};
+
+// hysteresis, the held value only follows once the value moved at least
+// width away from it. the ends of the range always get through.
+inline float rr_hysteresis(float value, float held, float width, float min, float max) {
+  if (std::fabs(value - held) >= width || value <= min || value >= max)
+    return value;
+  return held;
+}
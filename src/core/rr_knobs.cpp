@@ -0,0 +1,100 @@
+#include "rr_knobs.hpp"
+#include <algorithm>
+
+#ifdef RR_SIMD
+#include <simd/Vector.hpp>
+#include <simd/functions.hpp>
+#endif
+
+RRKnobBank::RRKnobBank() {
+  reset_holds();
+}
+
+void RRKnobBank::reset_holds() {
+  for (int i = 0; i < 128; i++)
+    cc_hold[i] = -INFINITY;
+}
+
+void RRKnobBank::convert(const RRKnobCC* knobs, int count, const float* knob, const float* cv, bool high_res, int32_t* out) {
+  // gather the lanes, unused lanes stay at 0
+  float value[4] = {}, volts[4] = {}, lo[4] = {}, hi[4] = {}, held[4] = {};
+  float has_cv[4] = {}, exp[4] = {};
+  for (int i = 0; i < count; i++) {
+    value[i] = knob[i];
+    has_cv[i] = !std::isnan(cv[i]);
+    volts[i] = has_cv[i] ? cv[i] : 0.f;
+    exp[i] = (knobs[i].curve == RR_CURVE_EXP);
+    lo[i] = knobs[i].min;
+    hi[i] = knobs[i].max;
+    held[i] = cc_hold[knobs[i].cc];
+  }
+
+  // scale into the CC range of the output resolution
+  float scale = high_res ? 16383 / 127.f : 1.f;
+
+  float cc[4];
+#ifdef RR_SIMD
+  using rack::simd::float_4;
+
+  // knob position (0-1), the cv overrides it and uses the knob as a ceiling
+  float_4 v = float_4::load(value) / 127.f;
+  float_4 connected = float_4::load(has_cv) != 0.f;
+  float_4 cv_value = rack::simd::fmin(rack::simd::fmax(float_4::load(volts) * 2.f / 10.f, 0.f), v);
+  v = rack::simd::ifelse(connected, cv_value, v);
+  v = rack::simd::ifelse(float_4::load(exp) != 0.f, v * v, v);
+
+  float_4 min = float_4::load(lo) * scale;
+  float_4 max = float_4::load(hi) * scale;
+  float_4 c = min + v * (max - min);
+
+  // hysteresis on the CV, the knob and the ends of the range always get through
+  float_4 last = float_4::load(held);
+  float_4 moved = (rack::simd::fabs(c - last) >= cv_hysteresis) | ~connected | (c <= min) | (c >= max);
+  rack::simd::ifelse(moved, c, last).store(cc);
+#else
+  // the same kernel one lane at a time, for the core library
+  for (int i = 0; i < 4; i++) {
+    float v = value[i] / 127.f;
+    float cv_value = std::min(std::max(volts[i] * 2.f / 10.f, 0.f), v);
+    v = has_cv[i] ? cv_value : v;
+    v = exp[i] ? v * v : v;
+
+    float min = lo[i] * scale;
+    float max = hi[i] * scale;
+    float c = min + v * (max - min);
+
+    bool moved = std::fabs(c - held[i]) >= cv_hysteresis || !has_cv[i] || c <= min || c >= max;
+    cc[i] = moved ? c : held[i];
+  }
+#endif
+
+  for (int i = 0; i < count; i++) {
+    cc_hold[knobs[i].cc] = cc[i];
+    // round (values are never negative)
+    out[i] = (int32_t) std::floor(cc[i] + 0.5f);
+  }
+}
+
+bool RRKnobBank::thin(RRCCCache* out, double now, int value, int cc) {
+  RRCCThinner& thinner = cc_thinners[cc];
+  if (cc_thin_error <= 0.f) {
+    thinner.pending = false;
+    return true;
+  }
+
+  // compare in 7-bit CC steps, a value that was dropped
+  // from the cache has to go out again
+  float steps = out->highResCCs ? value / 128.f : (float) value;
+  bool send = thinner.should_send(now, steps, cc_thin_error, out->getCachedCCValue(cc) == -1);
+  if (send)
+    thin_sent++;
+  else if (thinner.pending)
+    thin_suppressed++;
+  return send;
+}
+
+int RRKnobBank::hold_cv(float cv, int cc) {
+  float value = std::min(std::max(cv * 2 / 10.f * 127, 0.f), 127.f);
+  cc_hold[cc] = rr_hysteresis(value, cc_hold[cc], cv_hysteresis, 0.f, 127.f);
+  return (int) std::round(cc_hold[cc]);
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "rr_cc.hpp"
+#include "rr_timing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// knobs (and their CV inputs) that map onto CCs of the pedal. nothing in
+// here depends on Rack, the module hands over the param values and the
+// voltages.
+
+// response curves of a knob
+enum RRKnobCurves {
+  RR_CURVE_LINEAR,
+  // finer control at the bottom of the range
+  RR_CURVE_EXP
+};
+
+// describes how a knob (and its CV input) maps onto a CC of the pedal.
+// knob params are configured 0-127.
+struct RRKnobCC {
+  int param;
+  int input;
+  int cc;
+  int min;
+  int max;
+  int curve;
+};
+
+// peak tracking of a CV input across the samples the rate limiter skips,
+// so that short transients are not lost
+struct RRCVWindow {
+  float min = INFINITY;
+  float max = -INFINITY;
+  // the last decimated voltage
+  float last = 0.f;
+
+  // widens the window, a disconnected input (INFINITY) empties it
+  void add(float value) {
+    if (value == INFINITY) {
+      min = INFINITY;
+      max = -INFINITY;
+    } else {
+      min = std::min(min, value);
+      max = std::max(max, value);
+    }
+  }
+
+  // the voltage that best represents the input since the last call:
+  // whichever of the window's min and max moved further from the previous
+  // result. the next window starts at the current voltage.
+  float take(float current) {
+    if (min > max)
+      return current;
+    last = (std::fabs(max - last) > std::fabs(min - last)) ? max : min;
+    min = max = current;
+    return last;
+  }
+};
+
+// converts a module's knobs into CCs: curves, CV, hysteresis and thinning
+struct RRKnobBank {
+  static const int MAX_KNOBS = 16;
+
+  // CV hysteresis (in steps of the output resolution, 7 or 14-bit), a CC
+  // only follows its CV once it moved at least this far. keeps a noisy but
+  // static CV off the wire. off by default, it changes what a patch sends.
+  float cv_hysteresis = 0.f;
+  // the value each CC number is held at (output resolution, before
+  // rounding) and the resolution the holds are in
+  float cc_hold[128];
+  bool cc_hold_high_res = false;
+
+  // adaptive thinning of the knob CCs, the allowed extrapolation
+  // error (in CC steps). 0 sends every change.
+  float cc_thin_error = 0.f;
+  RRCCThinner cc_thinners[128];
+  // a knob's value was held back and still has to go out
+  bool thin_pending = false;
+  std::atomic<int64_t> thin_sent{0};
+  std::atomic<int64_t> thin_suppressed{0};
+
+  RRKnobBank();
+
+  void reset_holds();
+
+  // converts up to 4 knobs into CC values, 7-bit or 14-bit. knob holds the
+  // param values (0-127), cv the voltages (NAN when disconnected). written
+  // as 4 lane loops so that the compiler can vectorize them.
+  void convert(const RRKnobCC* knobs, int count, const float* knob, const float* cv, bool high_res, int32_t* out);
+
+  // false when the thinner holds the value back
+  bool thin(RRCCCache* out, double now, int value, int cc);
+
+  // CV hysteresis for a CV that goes straight onto a 7-bit CC (clamped
+  // between 0-127)
+  int hold_cv(float cv, int cc);
+
+  // sends the knobs whose period is up, the others keep collecting their
+  // CV peaks. read(knob, &value, &cv) is only called for the due knobs.
+  template <typename Read>
+  void send(RRCCCache* out, RRControlClock* clock, double now, const RRKnobCC* knobs, int count, Read read) {
+    // the held values are in the old resolution
+    if (cc_hold_high_res != out->highResCCs) {
+      cc_hold_high_res = out->highResCCs;
+      reset_holds();
+    }
+
+    RRKnobCC due[MAX_KNOBS];
+    float knob[MAX_KNOBS + 3] = {};
+    float cv[MAX_KNOBS + 3] = {};
+    int num_due = 0;
+    for (int i = 0; i < count && num_due < MAX_KNOBS; i++) {
+      if (!clock->cc_due(knobs[i].cc, now))
+        continue;
+      due[num_due] = knobs[i];
+      read(knobs[i], &knob[num_due], &cv[num_due]);
+      num_due++;
+    }
+
+    // convert them, 4 knobs at a time, into one contiguous buffer
+    int32_t values[MAX_KNOBS + 3];
+    for (int i = 0; i < num_due; i += 4)
+      convert(&due[i], std::min(4, num_due - i), &knob[i], &cv[i], out->highResCCs, &values[i]);
+
+    for (int i = 0; i < num_due; i++) {
+      if (!thin(out, now, values[i], due[i].cc))
+        continue;
+      if (out->highResCCs)
+        out->sendCachedCC14(values[i], due[i].cc);
+      else
+        out->sendCachedCC(values[i], due[i].cc);
+    }
+
+    // a held back value of any knob (due or not) still has to go out
+    thin_pending = false;
+    for (int i = 0; i < count; i++)
+      thin_pending |= cc_thinners[knobs[i].cc].pending;
+  }
+};
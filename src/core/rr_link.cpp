@@ -0,0 +1,42 @@
+#include "rr_link.hpp"
+#include <math.h>
+
+constexpr double RRDinLink::BYTE_TIME;
+
+int RRDinLink::backlog(double now) {
+  if (busy_until <= now)
+    return 0;
+  return (int) ceil((busy_until - now) / BYTE_TIME);
+}
+
+bool RRDinLink::transmit(double now, int size, double* delay) {
+  // the interface buffer overflows
+  if (backlog(now) + size > buffer_size) {
+    drops++;
+    return false;
+  }
+
+  // the bytes go out behind everything that is still queued
+  double start = (busy_until > now) ? busy_until : now;
+  busy_until = start + size * BYTE_TIME;
+
+  *delay = busy_until - now;
+  messages++;
+  bytes += size;
+  delay_sum += *delay;
+  if (*delay > delay_max)
+    delay_max = *delay;
+  return true;
+}
+
+double RRDinLink::avg_delay() {
+  return messages ? delay_sum / messages : 0.0;
+}
+
+void RRDinLink::reset_stats() {
+  messages = 0;
+  bytes = 0;
+  drops = 0;
+  delay_sum = 0.0;
+  delay_max = 0.0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+// timing model of a 5-pin DIN MIDI link. it runs at 31.25 kbaud with 10
+// bits per byte, so every byte takes 320us on the wire. the interface in
+// front of it buffers a limited number of bytes and drops a message that
+// doesn't fit. nothing in here depends on Rack, times are in seconds.
+struct RRDinLink {
+  static constexpr double BYTE_TIME = 320e-6;
+
+  // bytes the interface can hold (including the one on the wire)
+  int buffer_size = 64;
+
+  // when the last accepted byte has left the wire
+  double busy_until = 0.0;
+
+  // stats
+  uint64_t messages = 0;
+  uint64_t bytes = 0;
+  uint64_t drops = 0;
+  double delay_sum = 0.0;
+  double delay_max = 0.0;
+
+  // bytes still waiting for the wire at the given time
+  int backlog(double now);
+
+  // hands a message of size bytes to the interface at the given time.
+  // returns false if it was dropped, otherwise delay is set to the time
+  // until its last byte arrives at the pedal.
+  bool transmit(double now, int size, double* delay);
+
+  double avg_delay();
+  void reset_stats();
+};
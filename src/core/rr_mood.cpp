@@ -0,0 +1,29 @@
+#include "rr_mood.hpp"
+
+int RRMoodSwitches::process(RRCCCache* out, int blood_prog, int route_prog, int loop_prog) {
+  // assign values from switches
+  out->sendCachedCCNow(blood_prog, 21);
+  out->sendCachedCCNow(route_prog, 22);
+  out->sendCachedCCNow(loop_prog, 23);
+
+  // if a new loop program went out, the pedal bypassed
+  // the loop section, so force a bypass
+  int wire = out->getCachedCCValue(23);
+  if (wire >= 0 && wire != wire_loop_prog)
+    loop = false;
+  wire_loop_prog = wire;
+
+  int bypass;
+  if (loop && blood)
+    bypass = 127;
+  else if (!loop && blood)
+    bypass = 85;
+  else if (loop && !blood)
+    bypass = 45;
+  else
+    bypass = 0;
+
+  // bypass the blood and/or loop channels
+  out->sendCachedCCNow(bypass, 103);
+  return bypass;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "rr_cc.hpp"
+
+// the channel switches of the MOOD: the programs of the blood (CC 21) and
+// loop (CC 23) channels, the routing (CC 22) and the bypass of the two
+// channels (CC 103). nothing in here depends on Rack.
+struct RRMoodSwitches {
+  // the channels are on (bypass buttons or gates)
+  bool blood = false;
+  bool loop = false;
+
+  // the loop program last seen on the wire, -1 if none
+  int wire_loop_prog = -1;
+
+  // sends the switches right away, past the rate-limited flush. a new
+  // loop program bypasses the loop channel on the pedal, so loop is
+  // switched off to follow it. returns the bypass value that was sent.
+  int process(RRCCCache* out, int blood_prog, int route_prog, int loop_prog);
+};
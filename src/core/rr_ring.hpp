@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// wait-free rings for handing messages between threads without locks or
+// allocations. nothing in here depends on Rack.
+
+// wait-free single-producer / single-consumer ring, S is a power of 2
+template <typename T, size_t S>
+struct RRRing {
+  T data[S];
+  std::atomic<size_t> start{0};
+  std::atomic<size_t> end{0};
+
+  bool empty() const {
+    return start == end;
+  }
+
+  bool full() const {
+    return end - start >= S;
+  }
+
+  size_t size() const {
+    return end - start;
+  }
+
+  void push(const T& t) {
+    size_t i = end.load(std::memory_order_relaxed);
+    data[i & (S - 1)] = t;
+    end.store(i + 1, std::memory_order_release);
+  }
+
+  T shift() {
+    size_t i = start.load(std::memory_order_relaxed);
+    T t = data[i & (S - 1)];
+    start.store(i + 1, std::memory_order_release);
+    return t;
+  }
+};
+
+// lock-free multi-producer / single-consumer ring, S is a power of 2. every
+// cell carries a sequence number: a producer claims a cell by bumping end
+// and publishes it with the sequence, so producers never wait for a lock
+// (or for each other, unless they went for the same cell).
+template <typename T, size_t S>
+struct RRMpscRing {
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  Cell cells[S];
+  std::atomic<size_t> end{0};
+  // only touched by the consumer
+  size_t start = 0;
+
+  RRMpscRing() {
+    for (size_t i = 0; i < S; i++)
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // returns false when the ring is full
+  bool push(const T& t) {
+    size_t i = end.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[i & (S - 1)];
+      intptr_t diff = (intptr_t) cell->sequence.load(std::memory_order_acquire) - (intptr_t) i;
+      if (diff == 0) {
+        // the cell is free, claim it
+        if (end.compare_exchange_weak(i, i + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        // the consumer didn't get to it yet
+        return false;
+      } else {
+        // another producer got it first
+        i = end.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->data = t;
+    cell->sequence.store(i + 1, std::memory_order_release);
+    return true;
+  }
+
+  // returns false when there is nothing (published) to take
+  bool shift(T* t) {
+    Cell* cell = &cells[start & (S - 1)];
+    if (cell->sequence.load(std::memory_order_acquire) != start + 1)
+      return false;
+
+    *t = cell->data;
+    // free for the producers of the next lap
+    cell->sequence.store(start + S, std::memory_order_release);
+    start++;
+    return true;
+  }
+};
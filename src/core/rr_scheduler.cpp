@@ -0,0 +1,288 @@
+#include "rr_scheduler.hpp"
+#include <algorithm>
+
+constexpr double RRMidiScheduler::RUNNING_STATUS_TIMEOUT;
+
+void RRMidiQueue::clearContinuous() {
+  while (!continuousOrder.empty()) {
+    continuousPending[continuousOrder.front()] = false;
+    continuousOrder.pop_front();
+  }
+  continuousBacklog = 0;
+}
+
+void RRMidiScheduler::addQueue(RRMidiQueue* queue) {
+  queues.push_back(queue);
+}
+
+void RRMidiScheduler::removeQueue(RRMidiQueue* queue) {
+  for (size_t i = 0; i < queues.size(); i++) {
+    if (queues[i] == queue) {
+      queues.erase(queues.begin() + i);
+      break;
+    }
+  }
+
+  // whatever was still waiting won't go to this device anymore
+  queue->clearContinuous();
+}
+
+RRMidiDeviceStats RRMidiScheduler::getStats() {
+  RRMidiDeviceStats stats;
+  stats.modules = queues.size();
+  stats.sent = sentMessages;
+  for (RRMidiQueue* queue : queues)
+    stats.lost += queue->overflows;
+  stats.hold = hold;
+  stats.avgQueueing = sentMessages ? queueingSum / sentMessages : 0.0;
+  stats.maxQueueing = queueingMax;
+  return stats;
+}
+
+void RRMidiScheduler::resetStats() {
+  sentMessages = 0;
+  queueingSum = 0.0;
+  queueingMax = 0.0;
+  for (RRMidiQueue* queue : queues)
+    queue->overflows = 0;
+}
+
+void RRMidiScheduler::setRate(float rate, double now) {
+  this->rate = rate;
+  tokens = BURST;
+  last_time = now;
+}
+
+void RRMidiScheduler::setTiming(int64_t blockFrame, double blockTime, double sampleTime, double hold) {
+  this->blockFrame = blockFrame;
+  this->blockTime = blockTime;
+  this->sampleTime = sampleTime;
+  this->hold = hold;
+}
+
+double RRMidiScheduler::poll(double now, double maxWait) {
+  this->now = now;
+  double wakeup = now + maxWait;
+
+  // pick up everything the modules queued
+  intake();
+
+  // the priority lane always goes first
+  while (!priority.empty() && due(priority.front(), &wakeup) && pace(priority.front())) {
+    transmit(priority.front());
+    priority.pop_front();
+  }
+
+  // then the knobs, as long as the wire has room
+  if (priority.empty())
+    sendContinuous(&wakeup);
+  return wakeup;
+}
+
+bool RRMidiScheduler::due(const RRMidiMessage& msg, double* wakeup) {
+  // the wall clock time of the frame the message was generated on
+  double time = frameTime(msg) + hold;
+  if (time <= now)
+    return true;
+
+  // not yet, make sure we wake up for it
+  if (time < *wakeup)
+    *wakeup = time;
+  return false;
+}
+
+void RRMidiScheduler::intake() {
+  // one message per module at a time, so that a busy module can't
+  // push the others to the back of the priority lane
+  bool more = true;
+  while (more) {
+    more = false;
+    for (RRMidiQueue* queue : queues) {
+      if (queue->ring.empty())
+        continue;
+      RRMidiMessage msg = queue->ring.shift();
+      more = true;
+
+      // meant for the device the queue was on before
+      if (msg.generation != queue->generation)
+        continue;
+      schedule(queue, msg);
+    }
+  }
+}
+
+void RRMidiScheduler::schedule(RRMidiQueue* queue, const RRMidiMessage& msg) {
+  if (msg.priority) {
+    // a program change must not overtake the CCs that were flushed
+    // before it (see RRCCCache::setProgram()), send them first
+    if ((msg.bytes[0] & 0xf0) == 0xc0)
+      promoteContinuous(queue);
+    insertPriority(msg);
+    return;
+  }
+
+  int slot = msg.slot;
+  if (queue->continuousPending[slot]) {
+    RRMidiMessage& waiting = queue->continuous[slot];
+
+    // an LSB-only update rides along with the MSB that is still waiting,
+    // a new MSB resets the LSB on the pedal and replaces both
+    if (msg.bytes[1] != slot && waiting.bytes[1] == slot) {
+      waiting.lsb = msg.bytes[2];
+      return;
+    }
+
+    // replace the value that is still waiting for the wire
+    waiting = msg;
+    return;
+  }
+
+  queue->continuous[slot] = msg;
+  queue->continuousPending[slot] = true;
+  queue->continuousOrder.push_back(slot);
+  queue->continuousBacklog++;
+}
+
+void RRMidiScheduler::insertPriority(const RRMidiMessage& msg) {
+  // keep the priority lane in frame order across the modules
+  auto it = priority.end();
+  while (it != priority.begin() && (it - 1)->frame > msg.frame)
+    it--;
+  priority.insert(it, msg);
+}
+
+void RRMidiScheduler::promoteContinuous(RRMidiQueue* queue) {
+  // moves the continuous CCs of the queue to the priority lane
+  while (!queue->continuousOrder.empty()) {
+    int cc = queue->continuousOrder.front();
+    insertPriority(queue->continuous[cc]);
+    queue->continuousPending[cc] = false;
+    queue->continuousOrder.pop_front();
+    queue->continuousBacklog--;
+  }
+}
+
+void RRMidiScheduler::sendContinuous(double* wakeup) {
+  // round-robin over the modules, one CC each per turn
+  size_t idle = 0;
+  while (idle < queues.size()) {
+    if (nextQueue >= queues.size())
+      nextQueue = 0;
+    RRMidiQueue* queue = queues[nextQueue];
+
+    int cc = queue->continuousOrder.empty() ? -1 : queue->continuousOrder.front();
+    if (cc < 0 || !due(queue->continuous[cc], wakeup)) {
+      idle++;
+      nextQueue++;
+      continue;
+    }
+
+    if (!pace(queue->continuous[cc]))
+      return;
+    transmit(queue->continuous[cc]);
+    queue->continuousPending[cc] = false;
+    queue->continuousOrder.pop_front();
+    queue->continuousBacklog--;
+
+    idle = 0;
+    nextQueue++;
+  }
+}
+
+bool RRMidiScheduler::needsBreaker(const RRMidiMessage& msg) {
+  switch (breakerMode) {
+    case BREAKER_ALWAYS:
+      return msg.dummy;
+    case BREAKER_NEVER:
+      return false;
+    default:
+      // running status only kicks in for a repeated status byte
+      if (!msg.dummy && !lastProtected)
+        return false;
+      if (msg.bytes[0] != lastStatus)
+        return false;
+      if (breakerMode == BREAKER_SMART_IDLE && now - lastSendTime > RUNNING_STATUS_TIMEOUT)
+        return false;
+      return true;
+  }
+}
+
+int RRMidiScheduler::wireSize(const RRMidiMessage& msg) {
+  int size = msg.size + (needsBreaker(msg) ? 3 : 0);
+
+  // the LSB repeats the status of the MSB
+  if (msg.lsb >= 0)
+    size += 3 + (msg.dummy && breakerMode != BREAKER_NEVER ? 3 : 0);
+  return size;
+}
+
+bool RRMidiScheduler::pace(const RRMidiMessage& msg) {
+  if (rate <= 0.f)
+    return true;
+
+  // refill the bucket for the time that went by
+  tokens = std::min(tokens + (now - last_time) * rate, (double) BURST);
+  last_time = now;
+
+  int size = wireSize(msg);
+  if (tokens < size)
+    return false;
+  tokens -= size;
+  return true;
+}
+
+void RRMidiScheduler::transmit(const RRMidiMessage& msg) {
+  bool breaker = needsBreaker(msg);
+
+  // the smart modes break the running status right in front of the
+  // message that would have reused it
+  if (breaker && breakerMode != BREAKER_ALWAYS)
+    sendBreaker(msg);
+
+  sendBytes(msg.bytes, msg.size, msg.frame);
+  lastProtected = msg.dummy;
+
+  // the dummy message goes out right behind its CC on the same channel,
+  // before any other module gets a chance to reuse the running status
+  if (breaker && breakerMode == BREAKER_ALWAYS)
+    sendBreaker(msg);
+
+  savedBytes += (msg.dummy ? 3 : 0) - (breaker ? 3 : 0);
+
+  // how long the message waited after its hold
+  double queueing = now - (frameTime(msg) + hold);
+  sentMessages++;
+  queueingSum += queueing;
+  queueingMax = std::max(queueingMax, queueing);
+
+  // the LSB of a 14-bit CC has to follow its MSB, as the receiver
+  // clears the LSB whenever it gets a new MSB
+  if (msg.lsb >= 0) {
+    RRMidiMessage lsb = msg;
+    lsb.bytes[1] = msg.bytes[1] + 32;
+    lsb.bytes[2] = msg.lsb;
+    lsb.lsb = -1;
+    transmit(lsb);
+  }
+}
+
+void RRMidiScheduler::sendBreaker(const RRMidiMessage& msg) {
+  // send a bogus midi message (key pressure) that
+  // the CBA pedals don't understand to invalidate
+  // MIDI's Running Status feature that causes CBA
+  // pedals to drop consecutive messages.
+  uint8_t bytes[3] = {(uint8_t) (0x80 | (msg.bytes[0] & 0x0f)), 64, 1};
+  sendBytes(bytes, 3, msg.frame);
+}
+
+void RRMidiScheduler::sendBytes(const uint8_t* bytes, int size, int64_t frame) {
+  send(bytes, size, frame);
+  lastSendTime = now;
+
+  // real-time messages don't touch the running status, system
+  // common messages cancel it
+  uint8_t status = bytes[0];
+  if (status >= 0xf8)
+    return;
+  lastStatus = status < 0xf0 ? status : 0;
+}
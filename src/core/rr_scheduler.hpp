@@ -0,0 +1,188 @@
+#pragma once
+
+#include "rr_ring.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// scheduling of the MIDI messages of every module that shares a device:
+// priority lane, coalesced knob CCs, wire pacing and running status.
+// nothing in here depends on Rack, the caller passes in the time and
+// implements the wire (RRMidiAggregator in rr_midi.hpp, a simulated
+// device in the bench).
+
+// fixed-size MIDI message, so that messages can be handed from the
+// audio thread to the sender thread without allocating.
+struct RRMidiMessage {
+  // engine frame the message was generated on
+  int64_t frame;
+  uint8_t bytes[3];
+  uint8_t size;
+  // protect the message from MIDI's running status with a dummy
+  // message (sent as one unit)
+  bool dummy;
+  // jumps ahead of the continuous knob CCs
+  bool priority;
+  // LSB (CC n+32) that goes out right behind a 14-bit MSB, -1 if none
+  int8_t lsb;
+  // continuous lane slot: the CC, or CC n for the LSB-only update of a
+  // 14-bit knob on CC n (see RRCCCache::isLSB()), so that it is coalesced
+  // with the MSB it belongs to
+  uint8_t slot;
+  // RRMidiQueue::generation the message was queued for
+  uint32_t generation;
+};
+
+// messages on their way from one output to its device's scheduler
+struct RRMidiQueue {
+  // wait-free single-producer (audio thread) / single-consumer (scheduler
+  // thread) ring. the audio thread never talks to the MIDI driver directly.
+  RRRing<RRMidiMessage, 1024> ring;
+  std::atomic<size_t> highWaterMark{0};
+  std::atomic<uint64_t> overflows{0};
+  // bumped when the queue moves to another device. the producer can be
+  // a message behind the switch, the scheduler drops what was queued
+  // for an older generation instead of sending it to the new device.
+  std::atomic<uint32_t> generation{0};
+
+  // continuous knob CCs waiting for the wire, coalesced per CC number
+  // (latest value wins). only touched by the scheduler.
+  RRMidiMessage continuous[128];
+  bool continuousPending[128];
+  std::deque<uint8_t> continuousOrder;
+  // size of continuousOrder, for the audio thread
+  std::atomic<size_t> continuousBacklog{0};
+
+  RRMidiQueue() {
+    for (int n = 0; n < 128; n++)
+      continuousPending[n] = false;
+  }
+
+  void push(const RRMidiMessage& msg) {
+    if (ring.full()) {
+      // the scheduler fell behind, drop the message
+      overflows++;
+      return;
+    }
+    ring.push(msg);
+
+    // keep track of how deep the ring got
+    size_t depth = ring.size();
+    if (depth > highWaterMark)
+      highWaterMark = depth;
+  }
+
+  // drops whatever was still waiting for the wire
+  void clearContinuous();
+};
+
+// numbers of one device, to see how far sharing it between modules scales
+struct RRMidiDeviceStats {
+  int modules = 0;
+  uint64_t sent = 0;
+  // dropped because a module's ring was full
+  uint64_t lost = 0;
+  // every message is held back for one engine block (seconds)
+  double hold = 0.0;
+  // from the end of the hold to the wire, the time spent queueing behind
+  // other messages and the wire rate (seconds)
+  double avgQueueing = 0.0;
+  double maxQueueing = 0.0;
+};
+
+struct RRMidiScheduler {
+  // bytes that may go out back to back (two CC + dummy units)
+  static const int BURST = 12;
+
+  // when to break MIDI's running status with a dummy message
+  enum BreakerModes {
+    // after every protected message
+    BREAKER_ALWAYS,
+    // only in front of a message that would reuse the running status
+    BREAKER_SMART,
+    // same, but not after the link was idle for a while
+    BREAKER_SMART_IDLE,
+    BREAKER_NEVER,
+    NUM_BREAKER_MODES
+  };
+
+  // idle time after which interfaces send the full status byte again
+  static constexpr double RUNNING_STATUS_TIMEOUT = 0.05;
+
+  std::vector<RRMidiQueue*> queues;
+  size_t nextQueue = 0;
+
+  // priority messages from all modules, in frame order
+  std::deque<RRMidiMessage> priority;
+
+  // token bucket. a 5-pin DIN link runs at 31.25 kbaud (10 bits per byte)
+  // so it only carries ~3125 bytes/s. a rate of 0 means unlimited.
+  float rate = 0.f;
+  double tokens = 0.0;
+  double last_time = 0.0;
+
+  // running status tracking
+  int breakerMode = BREAKER_ALWAYS;
+  uint8_t lastStatus = 0;
+  bool lastProtected = false;
+  double lastSendTime = 0.0;
+  // wire bytes saved compared to always sending the dummy message
+  std::atomic<int64_t> savedBytes{0};
+
+  // queueing latency and throughput, see getStats()
+  uint64_t sentMessages = 0;
+  double queueingSum = 0.0;
+  double queueingMax = 0.0;
+
+  // engine timing: the frame and time the current block started at, and
+  // how long messages are held back (see setTiming())
+  int64_t blockFrame = 0;
+  double blockTime = 0.0;
+  double sampleTime = 0.0;
+  double hold = 0.0;
+
+  // the time of the current pass (seconds)
+  double now = 0.0;
+
+  virtual ~RRMidiScheduler() {}
+
+  // puts the bytes of one message on the wire
+  virtual void send(const uint8_t* bytes, int size, int64_t frame) = 0;
+
+  void addQueue(RRMidiQueue* queue);
+  void removeQueue(RRMidiQueue* queue);
+
+  RRMidiDeviceStats getStats();
+  void resetStats();
+
+  void setRate(float rate, double now);
+
+  // messages are released hold seconds after their frame, so that every
+  // message of a block is in before the first one is due
+  void setTiming(int64_t blockFrame, double blockTime, double sampleTime, double hold);
+
+  // one pass at the given time: picks up what the modules queued and sends
+  // what is due as long as the wire has room. returns when the next
+  // message is due (at most maxWait from now).
+  double poll(double now, double maxWait);
+
+  // the time the message was generated, and when it is released
+  double frameTime(const RRMidiMessage& msg) {
+    return blockTime + (msg.frame - blockFrame) * sampleTime;
+  }
+
+  bool due(const RRMidiMessage& msg, double* wakeup);
+  void intake();
+  void schedule(RRMidiQueue* queue, const RRMidiMessage& msg);
+  void insertPriority(const RRMidiMessage& msg);
+  void promoteContinuous(RRMidiQueue* queue);
+  void sendContinuous(double* wakeup);
+  bool needsBreaker(const RRMidiMessage& msg);
+  int wireSize(const RRMidiMessage& msg);
+  bool pace(const RRMidiMessage& msg);
+  void transmit(const RRMidiMessage& msg);
+  void sendBreaker(const RRMidiMessage& msg);
+  void sendBytes(const uint8_t* bytes, int size, int64_t frame);
+};
@@ -0,0 +1,155 @@
+#include "rr_timing.hpp"
+#include <algorithm>
+
+bool RRRateLimiter::process(float period, float sample_time) {
+  phase += sample_time / period;
+  if (phase >= 1.f) {
+    // no rate limiting needed, reduce the phase by 1
+    phase -= 1.f;
+    return false;
+  } else {
+    // apply rate limiting
+    return true;
+  }
+}
+
+void RRControlClock::set_period(float period) {
+  this->period = period;
+  update_tick();
+}
+
+void RRControlClock::set_cc_period(int cc, float period) {
+  cc_periods[cc] = period;
+  update_tick();
+}
+
+void RRControlClock::set_load_factor(int factor) {
+  if (factor != load_factor) {
+    load_factor = factor;
+    update_tick();
+  }
+}
+
+void RRControlClock::update_tick() {
+  tick = period;
+  for (int cc = 0; cc < 128; cc++) {
+    if (cc_periods[cc] > 0.f)
+      tick = std::min(tick, cc_periods[cc]);
+  }
+  tick *= load_factor;
+}
+
+bool RRControlClock::cc_due(int cc, double now) {
+  // half a tick of slack for the tick grid
+  if (now < cc_next_time[cc] - tick / 2) {
+    if (!cc_waiting[cc]) {
+      cc_waiting[cc] = true;
+      num_waiting++;
+    }
+    return false;
+  }
+
+  if (cc_waiting[cc]) {
+    cc_waiting[cc] = false;
+    num_waiting--;
+  }
+  cc_next_time[cc] = now + get_cc_period(cc);
+  return true;
+}
+
+float RRTapTempo::process(bool tap, double now, bool* tapped) {
+  float ret_brightness = -1.f;
+  *tapped = false;
+
+  if (can_tap && tap) {
+    // we are allowing tap tempo actions and they tapped the tempo button
+    *tapped = true;
+    can_tap = false;
+
+    // measure the amount of time from the previous tap tempo to this tap tempo.
+    // this will be the tap tempo rate (for the tap tempo LED).
+    // (dont allow slower than a 2s rate)
+    double tap_interval = now - last_tap_time;
+    if (tap_interval > 2.0)
+      tap_interval = 2.0;
+
+    // calculate the next time we need to blink
+    next_blink_time = now + (tap_interval / 2);
+
+    // update the current time
+    last_tap_time = now;
+
+    // keep track of whether two taps have occurred so far
+    if (!blinking && !first_tap) {
+      // first tap occurred
+      first_tap = true;
+    } else if (!blinking && first_tap) {
+      // second tap occurred, start blinking the light
+      blinking = true;
+      // the next time we blink, turn on the light
+      next_brightness = 1.f;
+    }
+
+    // calculate the blink rate based on the last two taps
+    // if we were told to start blinking
+    if (blinking)
+      rate = next_blink_time - now;
+
+  } else if (tap) {
+    // they wanted to do a tap tempo, but they did it too fast.
+    // calculate if enough time has elapsed (>100ms) to allow
+    // tapping next time
+    if (now - last_tap_time > 0.1)
+      can_tap = true;
+  } else {
+    // no tap tempo button was clicked, keep the tempo light blinking
+    ret_brightness = blink(now);
+  }
+
+  // return values:
+  //   ret_brightness < 0  --> don't change brightness.
+  //   ret_brightness >= 0 --> change brightness according
+  //                           to the retuned value.
+  return ret_brightness;
+}
+
+float RRTapTempo::blink(double now) {
+  if (!blinking)
+    return -1.f;
+
+  // if the current time is greater than the next blink time, flash the light.
+  // the next call will turn it off
+  double elapsed = now - next_blink_time;
+  if (elapsed <= 0)
+    return -1.f;
+
+  // flip the brightness value for the next blink
+  float ret_brightness = next_brightness;
+  next_brightness = !next_brightness;
+
+  // store the current time for the next blink, add rate and
+  // subtract the amount we went over because this accounts for
+  // the drift we may have experienced.
+  next_blink_time = (now + rate) - elapsed;
+  return ret_brightness;
+}
+
+float RRLedFlasher::process(float blink_rate, double now) {
+  // determine if we are in the blink off period by checking
+  // if the current time has not breached the blink off time window
+  if (now < blink_off_until) {
+    // we are in the quiet period
+    return 0.f;
+  }
+
+  // if the time since the last flash has exceeded the blink rate, then
+  // make now be the last time we blinked, and return a brightness of 0
+  if (now - last_blink_time > blink_rate) {
+    last_blink_time = now;
+    blink_off_until = now + 0.1;
+    return 0.f;
+  } else {
+    // we don't need to blink yet, keep the light on
+    return 1.f;
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// control timing of the pedals. nothing in here depends on Rack, the
+// module drives it with its own monotonic timebase (in seconds).
+
+// spreads the control blocks evenly over the samples
+struct RRRateLimiter {
+  float phase = 0.f;
+
+  // true while the control block should be skipped
+  bool process(float period, float sample_time);
+};
+
+// control rate of a module. the module has its own period and a CC can
+// override it with a slower or faster one (0 follows the module), the
+// control blocks run at the fastest of them (the tick) and every CC waits
+// for its own period. the load factor widens all of them.
+struct RRControlClock {
+  float period = 0.005f;
+  float cc_periods[128] = {};
+  float tick = 0.005f;
+  int load_factor = 1;
+
+  // when each CC is due next
+  double cc_next_time[128] = {};
+  // a control block wanted to send the CC before it was due, it has to
+  // be sent once it is due, even if nothing changes in the meantime
+  bool cc_waiting[128] = {};
+  int num_waiting = 0;
+
+  float get_cc_period(int cc) {
+    return ((cc_periods[cc] > 0.f) ? cc_periods[cc] : period) * load_factor;
+  }
+
+  void set_period(float period);
+  void set_cc_period(int cc, float period);
+  void set_load_factor(int factor);
+  void update_tick();
+
+  // true when the CC's period is up, otherwise the CC waits for it
+  bool cc_due(int cc, double now);
+
+  // CCs are waiting, the control blocks have to keep running
+  bool waiting() {
+    return num_waiting > 0;
+  }
+};
+
+// tap tempo button with a blinking tempo LED
+struct RRTapTempo {
+  bool can_tap = true;
+  double last_tap_time = 0.0;
+  double next_blink_time = 0.0;
+  bool blinking = false;
+  bool first_tap = false;
+  double rate = 0.0;
+  float next_brightness = 0.f;
+
+  // tapped is set when the tap should go out to the pedal.
+  // returns the new LED brightness, < 0 leaves it as it is.
+  float process(bool tap, double now, bool* tapped);
+
+  // only moves the LED, safe to call while the controls are idle
+  float blink(double now);
+};
+
+// LED that blinks off for 100ms every blink rate
+struct RRLedFlasher {
+  double last_blink_time = 0.0;
+  double blink_off_until = 0.0;
+
+  float process(float blink_rate, double now);
+};
@@ -4,6 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
 #include <dsp/digital.hpp>
 
 struct Cxm1978 : RRModule {
@@ -41,11 +42,23 @@ struct Cxm1978 : RRModule {
                   NUM_LIGHTS
   };
 
-  // grace period timevals
-  struct timeval preset_change_grace_period;
+  // sliders that map straight onto a CC, the cv uses the slider value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {BASS_SLIDER_PARAM,   BASS_SLIDER_INPUT,   14, 0, 127, RR_CURVE_LINEAR},
+    {MIDS_SLIDER_PARAM,   MIDS_SLIDER_INPUT,   15, 0, 127, RR_CURVE_LINEAR},
+    {CROSS_SLIDER_PARAM,  CROSS_SLIDER_INPUT,  16, 0, 127, RR_CURVE_LINEAR},
+    {TREBLE_SLIDER_PARAM, TREBLE_SLIDER_INPUT, 17, 0, 127, RR_CURVE_LINEAR},
+    {MIX_SLIDER_PARAM,    MIX_SLIDER_INPUT,    18, 0, 127, RR_CURVE_LINEAR},
+    {PREDLY_SLIDER_PARAM, PREDLY_SLIDER_INPUT, 19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  // grace period start time (timebase seconds)
+  double preset_change_grace_period = 0.0;
 
   Cxm1978() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    config_knobs(KNOBS);
 
     // main slider parameters
     configParam(BASS_SLIDER_PARAM, 0.f, 127.f, 0.f, "Bass (Decay Time Below Crossover)");
@@ -69,14 +82,19 @@ struct Cxm1978 : RRModule {
     configParam(CHANGE_PRESET_PARAM, 0.f, 1.f, 0.f, "Change Preset");
     configParam(BYPASS_PARAM, 0.f, 1.f, 0.f, "Enable/Bypass Pedal");
 
-    // initialize the first preset
-    midi_out.setProgram(0);
+    // start on the first preset once a device is attached
+    midi_out.setInitialProgram(0);
+  }
 
-    // initialize the loop select grace period
-    gettimeofday(&preset_change_grace_period, NULL);
+  bool timers_idle() override {
+    // the preset button repeats while held
+    return params[CHANGE_PRESET_PARAM].getValue() == 0.f;
   }
 
-  void process(const ProcessArgs& args) override {
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -89,6 +107,10 @@ struct Cxm1978 : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do
+    if (is_idle())
+      return;
+
     // read the bypass button values
     int enable_pedal = (int) floor(params[BYPASS_PARAM].getValue());
 
@@ -104,7 +126,7 @@ struct Cxm1978 : RRModule {
     }
 
     // bypass (or enable) the pedal
-    midi_out.sendCachedCC(bypass, 102);
+    midi_out.sendCachedCCNow(bypass, 102);
 
     // read the three-way arcade buttons values
     int jump_arcade = (int) floor(params[JUMP_ARCADE_PARAM].getValue());
@@ -114,11 +136,11 @@ struct Cxm1978 : RRModule {
     int clock_arcade = (int) floor(params[CLOCK_ARCADE_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(jump_arcade, 22);
-    midi_out.sendCachedCC(type_arcade, 23);
-    midi_out.sendCachedCC(diffusion_arcade, 24);
-    midi_out.sendCachedCC(tank_mod_arcade, 25);
-    midi_out.sendCachedCC(clock_arcade, 26);
+    midi_out.sendCachedCCNow(jump_arcade, 22);
+    midi_out.sendCachedCCNow(type_arcade, 23);
+    midi_out.sendCachedCCNow(diffusion_arcade, 24);
+    midi_out.sendCachedCCNow(tank_mod_arcade, 25);
+    midi_out.sendCachedCCNow(clock_arcade, 26);
 
     // check if the preset button was pressed
     // protect it from being spammed by limiting it
@@ -129,73 +151,31 @@ struct Cxm1978 : RRModule {
       midi_out.incrementProgram(1, 30);
 
       // start the preset change grace period
-      gettimeofday(&preset_change_grace_period, NULL);
+      preset_change_grace_period = curr_time;
     }
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the the user.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // slider values
-    int bass = (int) std::round(params[BASS_SLIDER_PARAM].getValue());
-    int mids = (int) std::round(params[MIDS_SLIDER_PARAM].getValue());
-    int cross = (int) std::round(params[CROSS_SLIDER_PARAM].getValue());
-    int treble = (int) std::round(params[TREBLE_SLIDER_PARAM].getValue());
-    int mix = (int) std::round(params[MIX_SLIDER_PARAM].getValue());
-    int predly = (int) std::round(params[PREDLY_SLIDER_PARAM].getValue());
-
-    // read cv voltages and override the values obtained from sliders positions
-    // clamp down the cv value to be between 0 and the value of the slider
-    if (inputs[BASS_SLIDER_INPUT].isConnected()) {
-      int bass_cv = convertCVtoCC(inputs[BASS_SLIDER_INPUT].getVoltage());
-      bass = clamp(bass_cv, 0, bass);
-    }
-    if (inputs[MIDS_SLIDER_INPUT].isConnected()) {
-      int mids_cv = convertCVtoCC(inputs[MIDS_SLIDER_INPUT].getVoltage());
-      mids = clamp(mids_cv, 0, mids);
-    }
-    if (inputs[CROSS_SLIDER_INPUT].isConnected()) {
-      int cross_cv = convertCVtoCC(inputs[CROSS_SLIDER_INPUT].getVoltage());
-      cross = clamp(cross_cv, 0, cross);
-    }
-    if (inputs[TREBLE_SLIDER_INPUT].isConnected()) {
-      int treble_cv = convertCVtoCC(inputs[TREBLE_SLIDER_INPUT].getVoltage());
-      treble = clamp(treble_cv, 0, treble);
-    }
-    if (inputs[MIX_SLIDER_INPUT].isConnected()) {
-      int mix_cv = convertCVtoCC(inputs[MIX_SLIDER_INPUT].getVoltage());
-      mix = clamp(mix_cv, 0, mix);
-    }
-    if (inputs[PREDLY_SLIDER_INPUT].isConnected()) {
-      int predly_cv = convertCVtoCC(inputs[PREDLY_SLIDER_INPUT].getVoltage());
-      predly = clamp(predly_cv, 0, predly);
-    }
+    // assign values from sliders (or cv)
+    send_knob_ccs(KNOBS);
 
-    // Assign values from knobs (or cv)
-    midi_out.sendCachedCC(bass, 14);
-    midi_out.sendCachedCC(mids, 15);
-    midi_out.sendCachedCC(cross, 16);
-    midi_out.sendCachedCC(treble, 17);
-    midi_out.sendCachedCC(mix, 18);
-    midi_out.sendCachedCC(predly, 19);
-
-    // read the expresion input if it is connected and clamp it between 0-127
-    int expr = -1;
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-
-      // assign value for expression
-      if (expr > 0)
-        midi_out.sendCachedCC(expr, 100);
-    }
+    // assign value for expression
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
 };
 
-struct Cxm1978Widget : ModuleWidget {
+constexpr RRKnobCC Cxm1978::KNOBS[];
+
+struct Cxm1978Widget : RRModuleWidget {
   Cxm1978Widget(Cxm1978* module) {
     setModule(module);
 
@@ -4,6 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
 
 struct Darkworld : RRModule {
   enum ParamIds {
@@ -41,10 +42,23 @@ struct Darkworld : RRModule {
                   NUM_LIGHTS
   };
 
-  dsp::SchmittTrigger dark_trigger_low, dark_trigger_high, world_trigger_low, world_trigger_high;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {DECAY_PARAM,     DECAY_INPUT,     14, 0, 127, RR_CURVE_LINEAR},
+    {MIX_PARAM,       MIX_INPUT,       15, 0, 127, RR_CURVE_LINEAR},
+    {DWELL_PARAM,     DWELL_INPUT,     16, 0, 127, RR_CURVE_LINEAR},
+    {MODIFY_PARAM,    MODIFY_INPUT,    17, 0, 127, RR_CURVE_LINEAR},
+    {TONE_PARAM,      TONE_INPUT,      18, 0, 127, RR_CURVE_LINEAR},
+    {PRE_DELAY_PARAM, PRE_DELAY_INPUT, 19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  RRGateBank<4> gates;
 
   Darkworld() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({BYPASS_DARK_INPUT_LOW, BYPASS_DARK_INPUT_HIGH, BYPASS_WORLD_INPUT_LOW, BYPASS_WORLD_INPUT_HIGH});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(DECAY_PARAM, 0.f, 127.f, 0.f, "Decay");
@@ -65,7 +79,10 @@ struct Darkworld : RRModule {
     configParam(BYPASS_WORLD_PARAM, 0.f, 1.f, 0.f, "Enable/Bypass World");
   }
 
-  void process(const ProcessArgs& args) override {
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -79,27 +96,24 @@ struct Darkworld : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do
+    if (is_idle())
+      return;
+
     // read the gate triggers
-    if (inputs[BYPASS_DARK_INPUT_HIGH].isConnected()) {
-      if (dark_trigger_high.process(rescale(inputs[BYPASS_DARK_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes high, turn on the dark channel
-        params[BYPASS_DARK_PARAM].setValue(1.f);
-    }
-    if (inputs[BYPASS_DARK_INPUT_LOW].isConnected()) {
-      if (dark_trigger_low.process(rescale(inputs[BYPASS_DARK_INPUT_LOW].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes low, turn off the dark channel
-        params[BYPASS_DARK_PARAM].setValue(0.f);
-    }
-    if (inputs[BYPASS_WORLD_INPUT_HIGH].isConnected()) {
-      if (world_trigger_high.process(rescale(inputs[BYPASS_WORLD_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes high, turn on the world channel
-        params[BYPASS_WORLD_PARAM].setValue(1.f);
-    }
-    if (inputs[BYPASS_WORLD_INPUT_LOW].isConnected()) {
-      if (world_trigger_low.process(rescale(inputs[BYPASS_WORLD_INPUT_LOW].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes low, turn off the world channel
-        params[BYPASS_WORLD_PARAM].setValue(0.f);
-    }
+    uint32_t triggered = gates.process(inputs);
+    if (triggered & (1 << BYPASS_DARK_INPUT_HIGH))
+      // if the trigger goes high, turn on the dark channel
+      params[BYPASS_DARK_PARAM].setValue(1.f);
+    if (triggered & (1 << BYPASS_DARK_INPUT_LOW))
+      // if the trigger goes low, turn off the dark channel
+      params[BYPASS_DARK_PARAM].setValue(0.f);
+    if (triggered & (1 << BYPASS_WORLD_INPUT_HIGH))
+      // if the trigger goes high, turn on the world channel
+      params[BYPASS_WORLD_PARAM].setValue(1.f);
+    if (triggered & (1 << BYPASS_WORLD_INPUT_LOW))
+      // if the trigger goes low, turn off the world channel
+      params[BYPASS_WORLD_PARAM].setValue(0.f);
 
     // read the bypass button values
     int enable_dark = (int) floor(params[BYPASS_DARK_PARAM].getValue());
@@ -133,7 +147,7 @@ struct Darkworld : RRModule {
     }
 
     // bypass the dark and/or world channels
-    midi_out.sendCachedCC(bypass, 103);
+    midi_out.sendCachedCCNow(bypass, 103);
 
     // read the three-way switch values
     int dark_prog = (int) floor(params[DARK_PROGRAM_PARAM].getValue());
@@ -141,72 +155,32 @@ struct Darkworld : RRModule {
     int world_prog = (int) floor(params[WORLD_PROGRAM_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(dark_prog, 21);
-    midi_out.sendCachedCC(route_prog, 22);
-    midi_out.sendCachedCC(world_prog, 23);
+    midi_out.sendCachedCCNow(dark_prog, 21);
+    midi_out.sendCachedCCNow(route_prog, 22);
+    midi_out.sendCachedCCNow(world_prog, 23);
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int decay = (int) std::round(params[DECAY_PARAM].getValue());
-    int mix = (int) std::round(params[MIX_PARAM].getValue());
-    int dwell = (int) std::round(params[DWELL_PARAM].getValue());
-    int modify = (int) std::round(params[MODIFY_PARAM].getValue());
-    int tone = (int) std::round(params[TONE_PARAM].getValue());
-    int pre_delay = (int) std::round(params[PRE_DELAY_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs,
-    // clamp down the cv value to be between 0 and the value of the knob
-    if (inputs[DECAY_INPUT].isConnected()) {
-      int decay_cv = convertCVtoCC(inputs[DECAY_INPUT].getVoltage());
-      decay = clamp(decay_cv, 0, decay);
-    }
-    if (inputs[MIX_INPUT].isConnected()) {
-      int mix_cv = convertCVtoCC(inputs[MIX_INPUT].getVoltage());
-      mix = clamp(mix_cv, 0, mix);
-    }
-    if (inputs[DWELL_INPUT].isConnected()) {
-      int dwell_cv = convertCVtoCC(inputs[DWELL_INPUT].getVoltage());
-      dwell = clamp(dwell_cv, 0, dwell);
-    }
-    if (inputs[TONE_INPUT].isConnected()) {
-      int tone_cv = convertCVtoCC(inputs[TONE_INPUT].getVoltage());
-      tone = clamp(tone_cv, 0, tone);
-    }
-    if (inputs[MODIFY_INPUT].isConnected()) {
-      int modify_cv = convertCVtoCC(inputs[MODIFY_INPUT].getVoltage());
-      modify = clamp(modify_cv, 0, modify);
-    }
-    if (inputs[PRE_DELAY_INPUT].isConnected()) {
-      int pre_delay_cv = convertCVtoCC(inputs[PRE_DELAY_INPUT].getVoltage());
-      pre_delay = clamp(pre_delay_cv, 0, pre_delay);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(decay, 14);
-    midi_out.sendCachedCC(mix, 15);
-    midi_out.sendCachedCC(dwell, 16);
-    midi_out.sendCachedCC(modify, 17);
-    midi_out.sendCachedCC(tone, 18);
-    midi_out.sendCachedCC(pre_delay, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
 };
 
-struct DarkworldWidget : ModuleWidget {
+constexpr RRKnobCC Darkworld::KNOBS[];
+
+struct DarkworldWidget : RRModuleWidget {
   DarkworldWidget(Darkworld* module) {
     setModule(module);
 
@@ -0,0 +1,559 @@
+#include "plugin.hpp"
+#include "rr_midiwidget.hpp"
+#include "rr_loopback.hpp"
+#include "core/rr_bytestream.hpp"
+#include "guicomponents.hpp"
+
+// pedals the emulator can stand in for
+enum EmulatedPedals {
+  EMU_DARKWORLD,
+  EMU_WARPEDVINYL,
+  EMU_MOOD,
+  EMU_GENLOSS,
+  EMU_THERMAE,
+  EMU_BLOOPER,
+  EMU_HABIT,
+  EMU_PREAMP_MK2,
+  EMU_CXM1978,
+  NUM_EMU_PEDALS
+};
+
+static const std::vector<std::string> EMU_PEDAL_NAMES = {
+  "Darkworld", "Warped Vinyl", "MOOD", "Generation Loss", "Thermae",
+  "Blooper", "Habit", "Preamp MKII", "CXM 1978"
+};
+
+// allowed difference in timing when comparing a recording with its
+// golden file (seconds), the recordings are made in real time
+static const double EMU_GOLDEN_TOLERANCE = 0.002;
+
+// module slugs, for naming the golden files
+static const char* const EMU_PEDAL_SLUGS[NUM_EMU_PEDALS] = {
+  "darkworld", "warpedvinyl", "mood", "genloss", "thermae",
+  "blooper", "habit", "preamp_mk2", "cxm1978"
+};
+
+// names of the knob CCs (14-19) of every pedal
+static const char* const EMU_KNOB_NAMES[NUM_EMU_PEDALS][6] = {
+  {"Decay", "Mix", "Dwell", "Modify", "Tone", "Pre-Delay"},
+  {"Tone", "Lag", "Mix", "RPM", "Depth", "Warp"},
+  {"Time", "Mix", "Length", "Mod Blood", "Clock", "Mod Loop"},
+  {"Wow", "Wet", "HP", "Flutter", "Gen", "LP"},
+  {"Mix", "LPF", "Regen", "Glide", "Int1", "Int2"},
+  {"Volume", "Layers", "Repeats", "Mod A", "Stability", "Mod B"},
+  {"Level", "Repeats", "Size", "Modify", "Spread", "Scan"},
+  {"Volume", "Treble", "Mids", "Freq", "Bass", "Gain"},
+  {"Bass", "Mids", "Cross", "Treble", "Mix", "Pre-Delay"}
+};
+
+// interface buffer sizes (bytes) for the DIN link model
+static const int EMU_LINK_BUFFERS[] = {16, 32, 64, 128, 256, 1024};
+static const int NUM_EMU_LINK_BUFFERS = 6;
+
+// blooper transport commands (CC 11)
+static const char* blooperTransportName(int value) {
+  switch (value) {
+    case 1: return "record";
+    case 2: return "play";
+    case 3: return "overdub";
+    case 4: return "stop";
+    case 7: return "erase";
+    default: return "-";
+  }
+}
+
+struct PedalEmulator : Module {
+  enum ParamIds { NUM_PARAMS };
+  enum InputIds { NUM_INPUTS };
+  enum OutputIds { NUM_OUTPUTS };
+  enum LightIds {
+                 RECEIVE_LIGHT,
+                 DROP_LIGHT,
+                 NUM_LIGHTS
+  };
+
+  // blooper needs this long to load a loop after a program change
+  static constexpr double BLOOPER_LOAD_TIME = 4.0;
+
+  // subscribed on all channels, the running status spans them all on a
+  // real wire. the pedal itself only listens to its channel (-1 for all).
+  midi::InputQueue midi_in;
+  int channel = -1;
+
+  int pedal = EMU_DARKWORLD;
+  // drop a message that repeats the status of the one before it, like a
+  // pedal behind an interface that uses MIDI's running status
+  bool running_status_drops = true;
+
+  // serialize the messages at DIN wire speed on their way to the
+  // emulator (see RRDinLink), to see the latency on the pedal side
+  bool link_enabled = false;
+  int link_buffer = 2;
+
+  double curr_time = 0.0;
+
+  // state of the pedal as far as it knows
+  int cc_values[128];
+  int program = -1;
+  uint8_t last_status = 0;
+
+  // counters
+  int64_t received = 0;
+  int64_t dropped = 0;
+  int64_t dummies = 0;
+
+  // how long the CCs kept changing after the last program change
+  double program_time = -1.0;
+  double settle_time = 0.0;
+
+  // blooper transport and loop slot
+  int transport = 0;
+  double loading_until = 0.0;
+  int64_t ignored = 0;
+
+  // set by the UI thread, the state is reset on the audio thread
+  std::atomic<bool> reset_requested{false};
+
+  // byte stream recording, compared against the pedal's golden file
+  bool recording = false;
+  RRByteStream recorded;
+  std::string golden_report;
+
+  // LED timing
+  double receive_light_until = 0.0;
+  double drop_light_until = 0.0;
+
+  PedalEmulator() {
+    config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    configLight(RECEIVE_LIGHT, "Message received");
+    configLight(DROP_LIGHT, "Message dropped (running status)");
+
+    // listen to the first loopback device out of the box
+    midi_in.setDriverId(RR_LOOPBACK_DRIVER_ID);
+    midi_in.setDeviceId(0);
+    midi_in.channel = -1;
+
+    reset_state();
+  }
+
+  ~PedalEmulator() {
+    RRLoopbackOutputDevice* device = get_loopback_device();
+    if (device)
+      device->setLink(false, EMU_LINK_BUFFERS[link_buffer]);
+  }
+
+  // the loopback device the emulator listens to, if any
+  RRLoopbackOutputDevice* get_loopback_device() {
+    if (!rrLoopbackDriver || midi_in.getDriverId() != RR_LOOPBACK_DRIVER_ID)
+      return NULL;
+    int device = midi_in.getDeviceId();
+    if (device < 0 || device >= RR_LOOPBACK_DEVICES)
+      return NULL;
+    return &rrLoopbackDriver->outputs[device];
+  }
+
+  void update_link() {
+    RRLoopbackOutputDevice* device = get_loopback_device();
+    if (device)
+      device->setLink(link_enabled, EMU_LINK_BUFFERS[link_buffer]);
+  }
+
+  std::string get_golden_path() {
+    return asset::user(string::f("RobRichards/golden/%s.txt", EMU_PEDAL_SLUGS[pedal]));
+  }
+
+  void start_recording() {
+    recorded.clear();
+    recorded.sampleRate = APP->engine->getSampleRate();
+    golden_report = "";
+    recording = true;
+  }
+
+  void stop_recording() {
+    recording = false;
+  }
+
+  void save_golden() {
+    std::string path = get_golden_path();
+    system::createDirectories(system::getDirectory(path));
+    if (recorded.save(path))
+      golden_report = string::f("saved %d messages", (int) recorded.events.size());
+    else
+      golden_report = "could not save";
+    INFO("golden byte stream %s: %s", path.c_str(), golden_report.c_str());
+  }
+
+  void compare_golden() {
+    RRByteStream golden;
+    if (!golden.load(get_golden_path())) {
+      golden_report = "no golden file";
+      return;
+    }
+    recorded.compare(golden, EMU_GOLDEN_TOLERANCE, &golden_report);
+    INFO("golden byte stream %s: %s", get_golden_path().c_str(), golden_report.c_str());
+  }
+
+  // picks up what went out to the loopback device, on the UI thread
+  void drain_capture() {
+    RRLoopbackOutputDevice* device = get_loopback_device();
+    if (!device)
+      return;
+
+    // thrown away when not recording, so that the ring is empty when
+    // recording starts
+    std::vector<RRLoopbackEvent> events;
+    device->drain(&events);
+    if (recording) {
+      for (const RRLoopbackEvent& event : events)
+        recorded.add(event.frame, event.bytes, event.size);
+    }
+  }
+
+  void reset_state() {
+    for (int n = 0; n < 128; n++)
+      cc_values[n] = -1;
+    program = -1;
+    last_status = 0;
+    received = 0;
+    dropped = 0;
+    dummies = 0;
+    program_time = -1.0;
+    settle_time = 0.0;
+    transport = 0;
+    loading_until = 0.0;
+    ignored = 0;
+  }
+
+  // resets the pedal from the UI thread, process() owns the state
+  void request_reset() {
+    reset_requested = true;
+
+    RRLoopbackOutputDevice* device = get_loopback_device();
+    if (device)
+      device->resetLinkStats();
+  }
+
+  void onReset() override {
+    request_reset();
+  }
+
+  bool is_loading() {
+    return pedal == EMU_BLOOPER && curr_time < loading_until;
+  }
+
+  bool drops_running_status(uint8_t status) {
+    // real-time messages don't touch the running status
+    if (status >= 0xf8)
+      return false;
+
+    // system common messages clear it
+    if (status >= 0xf0) {
+      last_status = 0;
+      return false;
+    }
+
+    bool repeated = status == last_status;
+    last_status = status;
+    return running_status_drops && repeated;
+  }
+
+  void receive(const midi::Message& msg) {
+    received++;
+    receive_light_until = curr_time + 0.05;
+
+    if (drops_running_status(msg.bytes[0])) {
+      dropped++;
+      drop_light_until = curr_time + 0.2;
+      return;
+    }
+
+    // the pedal only listens to its own channel
+    if (channel >= 0 && msg.getStatus() != 0xf && msg.getChannel() != channel)
+      return;
+
+    switch (msg.getStatus()) {
+      case 0x8:
+        // the dummy message that breaks the running status
+        dummies++;
+        break;
+
+      case 0xb: {
+        int cc = msg.getNote();
+        int value = msg.getValue();
+        if (pedal == EMU_BLOOPER && cc == 11) {
+          // transport commands are ignored while a loop loads
+          if (is_loading()) {
+            ignored++;
+            break;
+          }
+          transport = value;
+        }
+        cc_values[cc] = value;
+
+        // the preset is settled once the CCs stop changing
+        if (program_time >= 0.0)
+          settle_time = curr_time - program_time;
+      } break;
+
+      case 0xc:
+        program = msg.getNote();
+        program_time = curr_time;
+        settle_time = 0.0;
+
+        // a program change selects a loop slot on the blooper
+        if (pedal == EMU_BLOOPER) {
+          loading_until = curr_time + BLOOPER_LOAD_TIME;
+          transport = 4;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  void process(const ProcessArgs& args) override {
+    curr_time += args.sampleTime;
+
+    if (reset_requested.exchange(false))
+      reset_state();
+
+    midi::Message msg;
+    while (midi_in.tryPop(&msg, args.frame))
+      receive(msg);
+
+    lights[RECEIVE_LIGHT].setBrightness(curr_time < receive_light_until ? 1.f : 0.f);
+    lights[DROP_LIGHT].setBrightness(curr_time < drop_light_until ? 1.f : 0.f);
+  }
+
+  json_t* dataToJson() override {
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "midi", midi_in.toJson());
+    json_object_set_new(rootJ, "channel", json_integer(channel));
+    json_object_set_new(rootJ, "pedal", json_integer(pedal));
+    json_object_set_new(rootJ, "running_status_drops", json_boolean(running_status_drops));
+    json_object_set_new(rootJ, "link_enabled", json_boolean(link_enabled));
+    json_object_set_new(rootJ, "link_buffer", json_integer(link_buffer));
+    return rootJ;
+  }
+
+  void dataFromJson(json_t* rootJ) override {
+    json_t* midiJ = json_object_get(rootJ, "midi");
+    if (midiJ)
+      midi_in.fromJson(midiJ);
+
+    // older patches filtered on the port's channel
+    json_t* channelJ = json_object_get(rootJ, "channel");
+    channel = channelJ ? clamp((int) json_integer_value(channelJ), -1, 15) : midi_in.channel;
+    midi_in.channel = -1;
+
+    json_t* pedalJ = json_object_get(rootJ, "pedal");
+    if (pedalJ)
+      pedal = clamp((int) json_integer_value(pedalJ), 0, NUM_EMU_PEDALS - 1);
+
+    json_t* runningStatusDropsJ = json_object_get(rootJ, "running_status_drops");
+    if (runningStatusDropsJ)
+      running_status_drops = json_boolean_value(runningStatusDropsJ);
+
+    json_t* linkEnabledJ = json_object_get(rootJ, "link_enabled");
+    if (linkEnabledJ)
+      link_enabled = json_boolean_value(linkEnabledJ);
+
+    json_t* linkBufferJ = json_object_get(rootJ, "link_buffer");
+    if (linkBufferJ)
+      link_buffer = clamp((int) json_integer_value(linkBufferJ), 0, NUM_EMU_LINK_BUFFERS - 1);
+
+    update_link();
+  }
+};
+
+constexpr double PedalEmulator::BLOOPER_LOAD_TIME;
+
+// shows the modelled state of the pedal
+struct PedalEmulatorDisplay : LedDisplay {
+  PedalEmulator* module;
+
+  std::vector<std::string> getLines() {
+    std::vector<std::string> lines;
+    if (!module) {
+      lines.push_back("Pedal emulator");
+      return lines;
+    }
+
+    std::string program = (module->program >= 0) ? string::f("%d", module->program) : "-";
+    lines.push_back(string::f("%s  prog %s", EMU_PEDAL_NAMES[module->pedal].c_str(), program.c_str()));
+
+    // the knobs, unknown values show as -
+    for (int i = 0; i < 6; i++) {
+      int value = module->cc_values[14 + i];
+      lines.push_back(string::f("%-10s %s", EMU_KNOB_NAMES[module->pedal][i],
+        (value >= 0) ? string::f("%d", value).c_str() : "-"));
+    }
+
+    // bypass and expression
+    lines.push_back(string::f("byp %d/%d  expr %d", module->cc_values[102], module->cc_values[103], module->cc_values[100]));
+
+    if (module->pedal == EMU_BLOOPER) {
+      if (module->is_loading())
+        lines.push_back(string::f("loading loop %d (%.1fs)", module->program, module->loading_until - module->curr_time));
+      else
+        lines.push_back(string::f("transport: %s", blooperTransportName(module->transport)));
+      lines.push_back(string::f("ignored while loading: %lld", (long long) module->ignored));
+    }
+
+    lines.push_back(string::f("recv %lld  drop %lld", (long long) module->received, (long long) module->dropped));
+    lines.push_back(string::f("dummies %lld", (long long) module->dummies));
+    lines.push_back(string::f("preset settled: %.0f ms", module->settle_time * 1000));
+
+    // golden byte stream
+    if (module->recording)
+      lines.push_back(string::f("recording %d messages", (int) module->recorded.events.size()));
+    else if (!module->golden_report.empty())
+      lines.push_back("golden: " + module->golden_report);
+
+    // latency of the DIN link model
+    RRLoopbackOutputDevice* device = module->get_loopback_device();
+    if (device) {
+      RRLoopbackLinkStats stats = device->getLinkStats();
+      if (stats.enabled) {
+        lines.push_back(string::f("link avg %.1f max %.1f ms", stats.avgDelay * 1000, stats.maxDelay * 1000));
+        lines.push_back(string::f("link drops %llu/%llu", (unsigned long long) stats.drops,
+          (unsigned long long) (stats.messages + stats.drops)));
+      }
+    }
+    return lines;
+  }
+
+  void drawLayer(const DrawArgs& args, int layer) override {
+    if (layer == 1) {
+      std::shared_ptr<window::Font> font = APP->window->loadFont(asset::system("res/fonts/ShareTechMono-Regular.ttf"));
+      if (font) {
+        nvgFontFaceId(args.vg, font->handle);
+        nvgFontSize(args.vg, 10);
+        nvgTextAlign(args.vg, NVG_ALIGN_LEFT | NVG_ALIGN_TOP);
+        nvgFillColor(args.vg, nvgRGB(0xff, 0xd7, 0x14));
+
+        float y = 4;
+        for (const std::string& line : getLines()) {
+          nvgText(args.vg, 4, y, line.c_str(), NULL);
+          y += 12;
+        }
+      }
+    }
+    LedDisplay::drawLayer(args, layer);
+  }
+};
+
+struct PedalEmulatorWidget : ModuleWidget {
+  PedalEmulatorWidget(PedalEmulator* module) {
+    setModule(module);
+    setPanel(APP->window->loadSvg(asset::plugin(pluginInstance, "res/emulator_panel.svg")));
+
+    // screws
+    addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, 0)));
+    addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0)));
+    addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+    addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, RACK_GRID_HEIGHT - RACK_GRID_WIDTH)));
+
+    // midi configuration display
+    RRMidiWidget* midiWidget = createWidget<RRMidiWidget>(mm2px(Vec(3, 10)));
+    midiWidget->box.size = mm2px(Vec(54.96, 28));
+    midiWidget->setMidiPort(module ? &module->midi_in : NULL, module ? &module->channel : NULL);
+    addChild(midiWidget);
+
+    // modelled pedal state
+    PedalEmulatorDisplay* display = createWidget<PedalEmulatorDisplay>(mm2px(Vec(3, 41)));
+    display->box.size = mm2px(Vec(54.96, 66));
+    display->module = module;
+    addChild(display);
+
+    // activity lights
+    addChild(createLightCentered<LargeLight<GreenLight>>(mm2px(Vec(20, 116)), module, PedalEmulator::RECEIVE_LIGHT));
+    addChild(createLightCentered<LargeLight<RedLight>>(mm2px(Vec(41, 116)), module, PedalEmulator::DROP_LIGHT));
+  }
+
+  void step() override {
+    PedalEmulator* module = dynamic_cast<PedalEmulator*>(this->module);
+    if (module)
+      module->drain_capture();
+    ModuleWidget::step();
+  }
+
+  void appendContextMenu(ui::Menu* menu) override {
+    PedalEmulator* module = dynamic_cast<PedalEmulator*>(this->module);
+    if (!module)
+      return;
+
+    menu->addChild(new ui::MenuSeparator);
+    menu->addChild(createIndexSubmenuItem("Pedal", EMU_PEDAL_NAMES,
+      [=]() {
+        return (size_t) module->pedal;
+      },
+      [=](size_t i) {
+        module->pedal = i;
+        module->request_reset();
+      }
+    ));
+    menu->addChild(createBoolPtrMenuItem("Drop running status messages", "", &module->running_status_drops));
+
+    menu->addChild(createBoolMenuItem("DIN link model", "",
+      [=]() {
+        return module->link_enabled;
+      },
+      [=](bool enabled) {
+        module->link_enabled = enabled;
+        module->update_link();
+      }
+    ));
+
+    std::vector<std::string> bufferNames;
+    for (int i = 0; i < NUM_EMU_LINK_BUFFERS; i++)
+      bufferNames.push_back(string::f("%d bytes", EMU_LINK_BUFFERS[i]));
+    menu->addChild(createIndexSubmenuItem("Interface buffer", bufferNames,
+      [=]() {
+        return (size_t) module->link_buffer;
+      },
+      [=](size_t i) {
+        module->link_buffer = i;
+        module->update_link();
+      }
+    ));
+
+    // golden byte streams, see RRByteStream
+    menu->addChild(new ui::MenuSeparator);
+    menu->addChild(createMenuLabel("Golden byte stream"));
+    menu->addChild(createBoolMenuItem("Record", "",
+      [=]() {
+        return module->recording;
+      },
+      [=](bool record) {
+        if (record)
+          module->start_recording();
+        else
+          module->stop_recording();
+      }
+    ));
+    bool empty = module->recording || module->recorded.events.empty();
+    menu->addChild(createMenuItem("Save as golden file", "",
+      [=]() {
+        module->save_golden();
+      },
+      empty
+    ));
+    menu->addChild(createMenuItem("Compare with golden file", "",
+      [=]() {
+        module->compare_golden();
+      },
+      empty
+    ));
+
+    menu->addChild(new ui::MenuSeparator);
+    menu->addChild(createMenuItem("Reset pedal state", "",
+      [=]() {
+        module->request_reset();
+      }
+    ));
+  }
+};
+
+Model* modelPedalEmulator = createModel<PedalEmulator, PedalEmulatorWidget>("emulator");
@@ -4,6 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
 
 struct GenerationLoss : RRModule {
   enum ParamIds {
@@ -39,10 +40,23 @@ struct GenerationLoss : RRModule {
                   NUM_LIGHTS
   };
 
-  dsp::SchmittTrigger aux_trigger_low, aux_trigger_high;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {WOW_PARAM,     WOW_INPUT,     14, 0, 127, RR_CURVE_LINEAR},
+    {WET_PARAM,     WET_INPUT,     15, 0, 127, RR_CURVE_LINEAR},
+    {HP_PARAM,      HP_INPUT,      16, 0, 127, RR_CURVE_LINEAR},
+    {FLUTTER_PARAM, FLUTTER_INPUT, 17, 0, 127, RR_CURVE_LINEAR},
+    {GEN_PARAM,     GEN_INPUT,     18, 0, 127, RR_CURVE_LINEAR},
+    {LP_PARAM,      LP_INPUT,      19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  RRGateBank<2> gates;
 
   GenerationLoss() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({BYPASS_AUX_INPUT_LOW, BYPASS_AUX_INPUT_HIGH});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(WOW_PARAM, 0.f, 127.f, 0.f, "Wow");
@@ -63,7 +77,10 @@ struct GenerationLoss : RRModule {
     configParam(BYPASS_PEDAL_PARAM, 0.f, 1.f, 0.f, "Enable/Bypass Pedal");
   }
 
-  void process(const ProcessArgs& args) override {
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -77,17 +94,18 @@ struct GenerationLoss : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do
+    if (is_idle())
+      return;
+
     // read the gate triggers
-    if (inputs[BYPASS_AUX_INPUT_HIGH].isConnected()) {
-      if (aux_trigger_high.process(rescale(inputs[BYPASS_AUX_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes high, turn on the aux channel
-        params[BYPASS_AUX_PARAM].setValue(1.f);
-    }
-    if (inputs[BYPASS_AUX_INPUT_LOW].isConnected()) {
-      if (aux_trigger_low.process(rescale(inputs[BYPASS_AUX_INPUT_LOW].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes low, turn off the aux channel
-        params[BYPASS_AUX_PARAM].setValue(0.f);
-    }
+    uint32_t triggered = gates.process(inputs);
+    if (triggered & (1 << BYPASS_AUX_INPUT_HIGH))
+      // if the trigger goes high, turn on the aux channel
+      params[BYPASS_AUX_PARAM].setValue(1.f);
+    if (triggered & (1 << BYPASS_AUX_INPUT_LOW))
+      // if the trigger goes low, turn off the aux channel
+      params[BYPASS_AUX_PARAM].setValue(0.f);
 
     // read the bypass button values
     int enable_aux = (int) floor(params[BYPASS_AUX_PARAM].getValue());
@@ -121,7 +139,7 @@ struct GenerationLoss : RRModule {
     }
 
     // bypass the aux function and/or pedal
-    midi_out.sendCachedCC(bypass, 103);
+    midi_out.sendCachedCCNow(bypass, 103);
 
     // read the three-way switch values
     int aux_func = (int) floor(params[AUX_FUNC_PARAM].getValue());
@@ -129,70 +147,31 @@ struct GenerationLoss : RRModule {
     int hiss_func = (int) floor(params[HISS_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(aux_func, 21);
-    midi_out.sendCachedCC(dry_func, 22);
-    midi_out.sendCachedCC(hiss_func, 23);
+    midi_out.sendCachedCCNow(aux_func, 21);
+    midi_out.sendCachedCCNow(dry_func, 22);
+    midi_out.sendCachedCCNow(hiss_func, 23);
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int wow = (int) std::round(params[WOW_PARAM].getValue());
-    int wet = (int) std::round(params[WET_PARAM].getValue());
-    int hp= (int) std::round(params[HP_PARAM].getValue());
-    int flutter = (int) std::round(params[FLUTTER_PARAM].getValue());
-    int gen = (int) std::round(params[GEN_PARAM].getValue());
-    int lp = (int) std::round(params[LP_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs, use the knob value as a ceiling
-    if (inputs[WOW_INPUT].isConnected()) {
-      int wow_cv = convertCVtoCC(inputs[WOW_INPUT].getVoltage());
-      wow = clamp(wow_cv, 0, wow);
-    }
-    if (inputs[WET_INPUT].isConnected()) {
-      int wet_cv = convertCVtoCC(inputs[WET_INPUT].getVoltage());
-      wet = clamp(wet_cv, 0, wet);
-    }
-    if (inputs[HP_INPUT].isConnected()) {
-      int hp_cv = convertCVtoCC(inputs[HP_INPUT].getVoltage());
-      hp = clamp(hp_cv, 0, hp);
-    }
-    if (inputs[GEN_INPUT].isConnected()) {
-      int gen_cv = convertCVtoCC(inputs[GEN_INPUT].getVoltage());
-      gen = clamp(gen_cv, 0, gen);
-    }
-    if (inputs[FLUTTER_INPUT].isConnected()) {
-      int flutter_cv = convertCVtoCC(inputs[FLUTTER_INPUT].getVoltage());
-      flutter = clamp(flutter_cv, 0, flutter);
-    }
-    if (inputs[LP_INPUT].isConnected()) {
-      int lp_cv = convertCVtoCC(inputs[LP_INPUT].getVoltage());
-      lp = clamp(lp_cv, 0, lp);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(wow, 14);
-    midi_out.sendCachedCC(wet, 15);
-    midi_out.sendCachedCC(hp, 16);
-    midi_out.sendCachedCC(flutter, 17);
-    midi_out.sendCachedCC(gen, 18);
-    midi_out.sendCachedCC(lp, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
   }
 };
 
 
-struct GenerationLossWidget : ModuleWidget {
+constexpr RRKnobCC GenerationLoss::KNOBS[];
+
+struct GenerationLossWidget : RRModuleWidget {
   GenerationLossWidget(GenerationLoss* module) {
     setModule(module);
 
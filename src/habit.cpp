@@ -4,6 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
 #include <dsp/digital.hpp>
 
 struct Habit : RRModule {
@@ -45,9 +46,20 @@ struct Habit : RRModule {
 		  NUM_LIGHTS
   };
 
-  // periodic internal clock processing
-  dsp::ClockDivider disable_loop_hold_clk;
-  dsp::ClockDivider disable_scan_mode_clk;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {LEVEL_PARAM,   LEVEL_INPUT,   14, 0, 127, RR_CURVE_LINEAR},
+    {REPEATS_PARAM, REPEATS_INPUT, 15, 0, 127, RR_CURVE_LINEAR},
+    {SIZE_PARAM,    SIZE_INPUT,    16, 0, 127, RR_CURVE_LINEAR},
+    {MODIFY_PARAM,  MODIFY_INPUT,  17, 0, 127, RR_CURVE_LINEAR},
+    {SPREAD_PARAM,  SPREAD_INPUT,  18, 0, 127, RR_CURVE_LINEAR},
+    {SCAN_PARAM,    SCAN_INPUT,    19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  // periodic internal clock processing (timebase seconds)
+  double last_loop_hold_reset = 0.0;
+  double last_scan_mode_reset = 0.0;
   int disable_loop_hold_attempts = 0;
   int disable_scan_mode_attempts = 0;
 
@@ -57,10 +69,12 @@ struct Habit : RRModule {
   // bypass LED colors
   int curr_bypass_light_color = 1; // 1=red, 0=green
 
-  dsp::SchmittTrigger tap_tempo_trigger_high, bypass_trigger_low, bypass_trigger_high;
+  RRGateBank<3> gates;
 
   Habit() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({TAP_TEMPO_INPUT_HIGH, BYPASS_INPUT_LOW, BYPASS_INPUT_HIGH});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(LEVEL_PARAM, 0.f, 127.f, 64.f, "Volume Level (Wet/Dry)");
@@ -86,17 +100,29 @@ struct Habit : RRModule {
 
     // tap tempo buttons
     configParam(TAP_TEMPO_PARAM, 0.f, 1.f, 0.f, "Tap Tempo (Size Selection)");
+  }
 
-    // keep an internal clock to disable loop hold mode (~every 1s) for up
-    // to 5 times after it has been turned on.
-    disable_loop_hold_clk.setDivision(65536);
+  bool timers_idle() override {
+    // tap tempo repeats while held, the hold/scan resets run on a timer
+    return params[TAP_TEMPO_PARAM].getValue() == 0.f
+      && disable_loop_hold_attempts == 0
+      && disable_scan_mode_attempts == 0
+      && RRModule::timers_idle();
+  }
 
-    // keep an internal clock to disable scan mode (~every 1s) for up
-    // to 5 times after it has been turned on.
-    disable_scan_mode_clk.setDivision(65536);
+  void set_tap_tempo_light(float brightness) {
+    if (brightness >= 0) {
+      // flash the current color using the processed brightness value
+      lights[TAP_TEMPO_LIGHT + curr_tap_tempo_light_color].setBrightness(brightness);
+      // turn off the other color in case it is still on
+      lights[TAP_TEMPO_LIGHT + (!curr_tap_tempo_light_color)].setBrightness(0.f);
+    }
   }
 
-  void process(const ProcessArgs& args) override {
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -112,6 +138,12 @@ struct Habit : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do, the tempo LED keeps blinking
+    if (is_idle()) {
+      set_tap_tempo_light(blink_tap_tempo());
+      return;
+    }
+
     // handle a clock message
     if (inputs[CLOCK_INPUT].isConnected()) {
       bool clock = inputs[CLOCK_INPUT].getVoltage() >= 1.f;
@@ -150,33 +182,20 @@ struct Habit : RRModule {
     }
     
     // read the gate triggers
-    int tap_gate = 0;
-    if (inputs[TAP_TEMPO_INPUT_HIGH].isConnected()) {
-      if (tap_tempo_trigger_high.process(rescale(inputs[TAP_TEMPO_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f))) {
-	// if the trigger goes high, trigger a tap tempo
-	tap_gate = 1;
-      }
-    }
-    if (inputs[BYPASS_INPUT_HIGH].isConnected()) {
-      if (bypass_trigger_high.process(rescale(inputs[BYPASS_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
+    uint32_t triggered = gates.process(inputs);
+    // if the trigger goes high, trigger a tap tempo
+    int tap_gate = (triggered & (1 << TAP_TEMPO_INPUT_HIGH)) ? 1 : 0;
+    if (triggered & (1 << BYPASS_INPUT_HIGH))
 	// if the trigger goes high, enable the pedal
 	params[BYPASS_PARAM].setValue(1.f);
-    }
-    if (inputs[BYPASS_INPUT_LOW].isConnected()) {
-      if (bypass_trigger_low.process(rescale(inputs[BYPASS_INPUT_LOW].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
+    if (triggered & (1 << BYPASS_INPUT_LOW))
 	// if the trigger goes low, bypass the pedal
 	params[BYPASS_PARAM].setValue(0.f);
-    }
 
     // process any tap tempo requests
     int tap_tempo = (int) floor(params[TAP_TEMPO_PARAM].getValue());
     float tap_tempo_brightness = process_tap_tempo(tap_gate ? 1 : tap_tempo);
-    if (tap_tempo_brightness >= 0) {
-      // flash the current color using the processed brightness value
-      lights[TAP_TEMPO_LIGHT + curr_tap_tempo_light_color].setBrightness(tap_tempo_brightness);
-      // turn off the other color in case it is still on
-      lights[TAP_TEMPO_LIGHT + (!curr_tap_tempo_light_color)].setBrightness(0.f);
-    }
+    set_tap_tempo_light(tap_tempo_brightness);
 
     // bypass or enable the pedal
     int enable_pedal = (int) floor(params[BYPASS_PARAM].getValue());
@@ -195,7 +214,7 @@ struct Habit : RRModule {
     }
 
     // enable or bypass the pedal
-    midi_out.sendCachedCC(bypass, 102);
+    midi_out.sendCachedCCNow(bypass, 102);
 
     // 3way switch values (1,2,3)
     int l_toggle = (int) floor(params[L_TOGGLE_PARAM].getValue());
@@ -203,102 +222,67 @@ struct Habit : RRModule {
     int r_toggle = (int) floor(params[R_TOGGLE_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(l_toggle, 21);
-    midi_out.sendCachedCC(m_toggle, 22);
-    midi_out.sendCachedCC(r_toggle, 23);
+    midi_out.sendCachedCCNow(l_toggle, 21);
+    midi_out.sendCachedCCNow(m_toggle, 22);
+    midi_out.sendCachedCCNow(r_toggle, 23);
 
-    // periodically reset the CC message cache for loop hold if it is
+    // periodically (~every 1s) reset the CC message cache for loop hold if it is
     // not turned on by the user. This is so that it doesn't get stuck turned on.
     if (!loop_hold) {
-      if (disable_loop_hold_attempts > 0 && disable_loop_hold_clk.process()) {
+      if (disable_loop_hold_attempts > 0 && should_transition_to_state(1.0f, last_loop_hold_reset)) {
 	disable_loop_hold_attempts--;
+	last_loop_hold_reset = curr_time;
 	midi_out.resetCCCache(24);
       }
     } else {
       // hold mode is being requested, reset the hold mode attempts
       disable_loop_hold_attempts = 2;
+      last_loop_hold_reset = curr_time;
     }
 
-    // periodically reset the CC message cache for scan mode if it is
+    // periodically (~every 1s) reset the CC message cache for scan mode if it is
     // not turned on by the user. This is so that it doesn't get stuck turned on.
     if (!scan_mode) {
-      if (disable_scan_mode_attempts > 0 && disable_scan_mode_clk.process()) {
+      if (disable_scan_mode_attempts > 0 && should_transition_to_state(1.0f, last_scan_mode_reset)) {
 	disable_scan_mode_attempts--;
+	last_scan_mode_reset = curr_time;
 	midi_out.resetCCCache(25);
       }
     } else {
       // hold mode is being requested, reset the hold mode attempts
       disable_scan_mode_attempts = 2;
+      last_scan_mode_reset = curr_time;
     }
 
     // enable/disable loop and scan mode
-    midi_out.sendCachedCC(loop_hold, 24);
-    midi_out.sendCachedCC(scan_mode, 25);
+    midi_out.sendCachedCCNow(loop_hold, 24);
+    midi_out.sendCachedCCNow(scan_mode, 25);
 
     // reset the memory if toggled
-    midi_out.sendCachedCC(reset_toggle, 26);    
+    midi_out.sendCachedCCNow(reset_toggle, 26);    
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int level = (int) std::round(params[LEVEL_PARAM].getValue());
-    int repeats = (int) std::round(params[REPEATS_PARAM].getValue());
-    int size = (int) std::round(params[SIZE_PARAM].getValue());
-    int modify = (int) std::round(params[MODIFY_PARAM].getValue());
-    int spread = (int) std::round(params[SPREAD_PARAM].getValue());
-    int scan = (int) std::round(params[SCAN_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs, use the knob value as a ceiling
-    if (inputs[LEVEL_INPUT].isConnected()) {
-      int level_cv = convertCVtoCC(inputs[LEVEL_INPUT].getVoltage());
-      level = clamp(level_cv, 0, level);
-    }
-    if (inputs[REPEATS_INPUT].isConnected()) {
-      int repeats_cv = convertCVtoCC(inputs[REPEATS_INPUT].getVoltage());
-      repeats = clamp(repeats_cv, 0, repeats);
-    }
-    if (inputs[SIZE_INPUT].isConnected()) {
-      int size_cv = convertCVtoCC(inputs[SIZE_INPUT].getVoltage());
-      size = clamp(size_cv, 0, size);
-    }
-    if (inputs[MODIFY_INPUT].isConnected()) {
-      int modify_cv = convertCVtoCC(inputs[MODIFY_INPUT].getVoltage());
-      modify = clamp(modify_cv, 0, modify);
-    }
-    if (inputs[SPREAD_INPUT].isConnected()) {
-      int spread_cv = convertCVtoCC(inputs[SPREAD_INPUT].getVoltage());
-      spread = clamp(spread_cv, 0, spread);
-    }
-    if (inputs[SCAN_INPUT].isConnected()) {
-      int scan_cv = convertCVtoCC(inputs[SCAN_INPUT].getVoltage());
-      scan = clamp(scan_cv, 0, scan);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(level, 14);
-    midi_out.sendCachedCC(repeats, 15);
-    midi_out.sendCachedCC(size, 16);
-    midi_out.sendCachedCC(modify, 17);
-    midi_out.sendCachedCC(spread, 18);
-    midi_out.sendCachedCC(scan, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
 };
 
-struct HabitWidget : ModuleWidget {
+constexpr RRKnobCC Habit::KNOBS[];
+
+struct HabitWidget : RRModuleWidget {
   HabitWidget(Habit* module) {
     setModule(module);
 
@@ -4,8 +4,9 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
+#include "core/rr_mood.hpp"
 #include <dsp/digital.hpp>
-#include <sys/time.h>
 
 struct Mood : RRModule {
   enum ParamIds {
@@ -43,15 +44,26 @@ struct Mood : RRModule {
                   NUM_LIGHTS
   };
 
-  dsp::SchmittTrigger blood_trigger_low, blood_trigger_high, loop_trigger_low, loop_trigger_high;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {TIME_PARAM,         TIME_INPUT,         14, 0, 127, RR_CURVE_LINEAR},
+    {MIX_PARAM,          MIX_INPUT,          15, 0, 127, RR_CURVE_LINEAR},
+    {LENGTH_PARAM,       LENGTH_INPUT,       16, 0, 127, RR_CURVE_LINEAR},
+    {MODIFY_BLOOD_PARAM, MODIFY_BLOOD_INPUT, 17, 0, 127, RR_CURVE_LINEAR},
+    {CLOCK_PARAM,        CLOCK_INPUT,        18, 0, 127, RR_CURVE_LINEAR},
+    {MODIFY_LOOP_PARAM,  MODIFY_LOOP_INPUT,  19, 0, 127, RR_CURVE_LINEAR}
+  };
 
-  // internal clock measurements
-  struct timeval last_blink_time;
-  double blink_off_until_usec = 0;
-  double blink_off_until_sec = 0;
+  RRGateBank<4> gates;
+  RRMoodSwitches switches;
+  // the clock the loop LED flashes at, kept for the idle fast path
+  int loop_led_clock = 64;
 
   Mood() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({BYPASS_BLOOD_INPUT_LOW, BYPASS_BLOOD_INPUT_HIGH, BYPASS_LOOP_INPUT_LOW, BYPASS_LOOP_INPUT_HIGH});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(TIME_PARAM, 0.f, 127.f, 0.f, "Time");
@@ -70,11 +82,12 @@ struct Mood : RRModule {
     // bypass buttons
     configParam(BYPASS_BLOOD_PARAM, 0.f, 1.f, 0.f, "Enable/Bypass Blood");
     configParam(BYPASS_LOOP_PARAM, 0.f, 1.f, 0.f, "Enable/Bypass Loop");
-
-    gettimeofday(&last_blink_time, NULL);
   }
 
-  void process(const ProcessArgs& args) override {
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -89,28 +102,28 @@ struct Mood : RRModule {
       enable_module();
     }
 
-    // read the gate triggers
-    if (inputs[BYPASS_BLOOD_INPUT_HIGH].isConnected()) {
-      if (blood_trigger_high.process(rescale(inputs[BYPASS_BLOOD_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes high, turn on the blood channel
-        params[BYPASS_BLOOD_PARAM].setValue(1.f);
-    }
-    if (inputs[BYPASS_BLOOD_INPUT_LOW].isConnected()) {
-      if (blood_trigger_low.process(rescale(inputs[BYPASS_BLOOD_INPUT_LOW].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes low, turn off the blood channel
-        params[BYPASS_BLOOD_PARAM].setValue(0.f);
-    }
-    if (inputs[BYPASS_LOOP_INPUT_HIGH].isConnected()) {
-      if (loop_trigger_high.process(rescale(inputs[BYPASS_LOOP_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes high, turn on the loop channel
-        params[BYPASS_LOOP_PARAM].setValue(1.f);
-    }
-    if (inputs[BYPASS_LOOP_INPUT_LOW].isConnected()) {
-      if (loop_trigger_low.process(rescale(inputs[BYPASS_LOOP_INPUT_LOW].getVoltage(), 0.1f, 2.f, 0.f, 1.f)))
-        // if the trigger goes low, turn off the loop channel
-        params[BYPASS_LOOP_PARAM].setValue(0.f);
+    // skip the rest if there is nothing to do, the loop LED keeps flashing
+    if (is_idle()) {
+      if (params[BYPASS_LOOP_PARAM].getValue() < 1.f)
+        lights[LOOP_LIGHT + 1].setBrightness(flash_loop_led(loop_led_clock));
+      return;
     }
 
+    // read the gate triggers
+    uint32_t triggered = gates.process(inputs);
+    if (triggered & (1 << BYPASS_BLOOD_INPUT_HIGH))
+      // if the trigger goes high, turn on the blood channel
+      params[BYPASS_BLOOD_PARAM].setValue(1.f);
+    if (triggered & (1 << BYPASS_BLOOD_INPUT_LOW))
+      // if the trigger goes low, turn off the blood channel
+      params[BYPASS_BLOOD_PARAM].setValue(0.f);
+    if (triggered & (1 << BYPASS_LOOP_INPUT_HIGH))
+      // if the trigger goes high, turn on the loop channel
+      params[BYPASS_LOOP_PARAM].setValue(1.f);
+    if (triggered & (1 << BYPASS_LOOP_INPUT_LOW))
+      // if the trigger goes low, turn off the loop channel
+      params[BYPASS_LOOP_PARAM].setValue(0.f);
+
     // pedal bypass switches
     int enable_blood = (int) floor(params[BYPASS_BLOOD_PARAM].getValue());
     int enable_loop = (int) floor(params[BYPASS_LOOP_PARAM].getValue());
@@ -120,13 +133,11 @@ struct Mood : RRModule {
     int route_prog = (int) floor(params[ROUTING_PARAM].getValue());
     int loop_prog = (int) floor(params[LOOP_PROGRAM_PARAM].getValue());
 
-    // assign values from switches
-    midi_out.sendCachedCC(blood_prog, 21);
-    midi_out.sendCachedCC(route_prog, 22);
-
-    // if the loop program is changed, the loop
-    // section gets bypassed, so force a bypass
-    if (midi_out.sendCachedCC(loop_prog, 23)) {
+    // assign values from switches, a new loop program forces a loop bypass
+    switches.blood = enable_blood;
+    switches.loop = enable_loop;
+    switches.process(&midi_out, blood_prog, route_prog, loop_prog);
+    if (enable_loop && !switches.loop) {
       enable_loop = 0;
       params[BYPASS_LOOP_PARAM].setValue(0.f);
     }
@@ -138,39 +149,32 @@ struct Mood : RRModule {
       int clock_cv = convertCVtoCC(inputs[CLOCK_INPUT].getVoltage());
       clock = clamp(clock_cv, 0, clock);
     }
+    loop_led_clock = clock;
 
-    int bypass;
     if (enable_loop && enable_blood) {
-      bypass = 127;
       // turn loop LED green (on)
       // turn blood LED green
       lights[LOOP_LIGHT + 0].setBrightness(1.f); // turn on green
       lights[LOOP_LIGHT + 1].setBrightness(0.f); // turn off red
       lights[BLOOD_LIGHT].setBrightness(1.f);
     } else if (!enable_loop && enable_blood) {
-      bypass = 85;
       // turn loop LED red (off)
       // turn blood LED on (green)
       lights[LOOP_LIGHT + 0].setBrightness(0.f); // turn off green
       lights[BLOOD_LIGHT].setBrightness(1.f);
     } else if (enable_loop && !enable_blood) {
-      bypass = 45;
       // turn loop LED green (on)
       // turn blood LED off
       lights[LOOP_LIGHT + 0].setBrightness(1.f); // turn on green
       lights[LOOP_LIGHT + 1].setBrightness(0.f); // turn off red
       lights[BLOOD_LIGHT].setBrightness(0.f);
     } else {
-      bypass = 0;
       // turn loop LED red (off)
       // turn blood LED off
       lights[LOOP_LIGHT + 0].setBrightness(0.f); // turn off green
       lights[BLOOD_LIGHT].setBrightness(0.f);
     }
 
-    // bypass the blood and/or loop channels
-    midi_out.sendCachedCC(bypass, 103);
-
     // if the loop is not on, flash the loop LED off-to-red
     // based on the sample rate of the clock knob.
     if (!enable_loop) {
@@ -179,54 +183,18 @@ struct Mood : RRModule {
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int time = (int) std::round(params[TIME_PARAM].getValue());
-    int mix = (int) std::round(params[MIX_PARAM].getValue());
-    int length = (int) std::round(params[LENGTH_PARAM].getValue());
-    int modify_blood = (int) std::round(params[MODIFY_BLOOD_PARAM].getValue());
-    int modify_loop = (int) std::round(params[MODIFY_LOOP_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs, use the knob value as a ceiling
-    if (inputs[TIME_INPUT].isConnected()) {
-      int time_cv = convertCVtoCC(inputs[TIME_INPUT].getVoltage());
-      time = clamp(time_cv, 0, time);
-    }
-    if (inputs[MIX_INPUT].isConnected()) {
-      int mix_cv = convertCVtoCC(inputs[MIX_INPUT].getVoltage());
-      mix = clamp(mix_cv, 0, mix);
-    }
-    if (inputs[LENGTH_INPUT].isConnected()) {
-      int length_cv = convertCVtoCC(inputs[LENGTH_INPUT].getVoltage());
-      length = clamp(length_cv, 0, length);
-    }
-    if (inputs[MODIFY_BLOOD_INPUT].isConnected()) {
-      int modify_blood_cv = convertCVtoCC(inputs[MODIFY_BLOOD_INPUT].getVoltage());
-      modify_blood = clamp(modify_blood_cv, 0, modify_blood);
-    }
-    if (inputs[MODIFY_LOOP_INPUT].isConnected()) {
-      int modify_loop_cv = convertCVtoCC(inputs[MODIFY_LOOP_INPUT].getVoltage());
-      modify_loop = clamp(modify_loop_cv, 0, modify_loop);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(time, 14);
-    midi_out.sendCachedCC(mix, 15);
-    midi_out.sendCachedCC(length, 16);
-    midi_out.sendCachedCC(modify_blood, 17);
-    midi_out.sendCachedCC(clock, 18);
-    midi_out.sendCachedCC(modify_loop, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
@@ -269,49 +237,15 @@ struct Mood : RRModule {
     else
       blink_rate = 16.0f;
 
-    // collect a current time stamp and compare it to a previously stored time stamp
-    // measure the amount of time from the previous tap tempo to this tap tempo.
-    // this will be the tap tempo rate (for the tap tempo LED).
-    double last_time_usec = (double) last_blink_time.tv_usec;
-    double last_time_sec = (double) last_blink_time.tv_sec;
-
-    // get a new measurement
-    struct timeval ctime;
-    gettimeofday(&ctime, NULL);
-    double this_time_usec = (double) ctime.tv_usec;
-    double this_time_sec = (double) ctime.tv_sec;
-
-    // determine if we are in the blink off period by checking
-    // if the current time has not breached the blink off time window
-    double blink_off_diff_sec = this_time_sec - blink_off_until_sec;
-    double blink_off_diff_usec = this_time_usec - blink_off_until_usec;
-    float blink_off_diff = (float) (blink_off_diff_sec + (blink_off_diff_usec/1000000));
-    if (blink_off_diff < 0) {
-      // we are in the quiet period
-      return 0.f;
-    }
-
-    // calculate how much time has gone by
-    double diff_sec = this_time_sec - last_time_sec;
-    double diff_usec = this_time_usec - last_time_usec;
-    float diff = (float) (diff_sec + (diff_usec/1000000));
-
-    // if the time diff has exceeded the blink rate, then make now be the last time
-    // we blinked, and return a brightness of 0
-    if (diff > blink_rate) {
-      last_blink_time = ctime;
-      blink_off_until_usec = (double) this_time_usec + 100000;
-      blink_off_until_sec = (double) this_time_sec;
-      return 0.f;
-    } else {
-      // we don't need to blink yet, keep the light on
-      return 1.f;
-    }
+    // flash the LED off at the blink rate
+    return flash_led(blink_rate);
   }
 
 };
 
-struct MoodWidget : ModuleWidget {
+constexpr RRKnobCC Mood::KNOBS[];
+
+struct MoodWidget : RRModuleWidget {
   MoodWidget(Mood* module) {
     setModule(module);
 
@@ -1,6 +1,8 @@
 #include "plugin.hpp"
+#include "rr_loopback.hpp"
 
 Plugin* pluginInstance;
+RRLoopbackDriver* rrLoopbackDriver;
 
 void init(Plugin* p) {
 	pluginInstance = p;
@@ -15,6 +17,11 @@ void init(Plugin* p) {
 	p->addModel(modelHabit);
 	p->addModel(modelPreampMKII);
 	p->addModel(modelCxm1978);
+	p->addModel(modelPedalEmulator);
+
+	// loopback MIDI devices for capturing the byte streams of the modules
+	rrLoopbackDriver = new RRLoopbackDriver;
+	midi::addDriver(RR_LOOPBACK_DRIVER_ID, rrLoopbackDriver);
 
 	// Any other plugin initialization may go here.
 	// As an alternative, consider lazy-loading assets and lookup tables when
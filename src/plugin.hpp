@@ -16,3 +16,4 @@ extern Model* modelBlooper;
 extern Model* modelHabit;
 extern Model* modelPreampMKII;
 extern Model* modelCxm1978;
+extern Model* modelPedalEmulator;
@@ -4,6 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
 #include <dsp/digital.hpp>
 
 struct PreampMKII : RRModule {
@@ -41,11 +42,23 @@ struct PreampMKII : RRModule {
                   NUM_LIGHTS
   };
 
-  // grace period timevals
-  struct timeval preset_change_grace_period;
+  // sliders that map straight onto a CC, the cv uses the slider value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {VOLUME_SLIDER_PARAM, VOLUME_SLIDER_INPUT, 14, 0, 127, RR_CURVE_LINEAR},
+    {TREBLE_SLIDER_PARAM, TREBLE_SLIDER_INPUT, 15, 0, 127, RR_CURVE_LINEAR},
+    {MIDS_SLIDER_PARAM,   MIDS_SLIDER_INPUT,   16, 0, 127, RR_CURVE_LINEAR},
+    {FREQ_SLIDER_PARAM,   FREQ_SLIDER_INPUT,   17, 0, 127, RR_CURVE_LINEAR},
+    {BASS_SLIDER_PARAM,   BASS_SLIDER_INPUT,   18, 0, 127, RR_CURVE_LINEAR},
+    {GAIN_SLIDER_PARAM,   GAIN_SLIDER_INPUT,   19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  // grace period start time (timebase seconds)
+  double preset_change_grace_period = 0.0;
 
   PreampMKII() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    config_knobs(KNOBS);
 
     // main slider parameters
     configParam(VOLUME_SLIDER_PARAM, 0.f, 127.f, 0.f, "Volume");
@@ -69,14 +82,19 @@ struct PreampMKII : RRModule {
     configParam(CHANGE_PRESET_PARAM, 0.f, 1.f, 0.f, "Change Preset");
     configParam(BYPASS_PARAM, 0.f, 1.f, 0.f, "Enable/Bypass Pedal");
 
-    // initialize the first preset
-    midi_out.setProgram(0);
+    // start on the first preset once a device is attached
+    midi_out.setInitialProgram(0);
+  }
 
-    // initialize the loop select grace period
-    gettimeofday(&preset_change_grace_period, NULL);
+  bool timers_idle() override {
+    // the preset button repeats while held
+    return params[CHANGE_PRESET_PARAM].getValue() == 0.f;
   }
 
-  void process(const ProcessArgs& args) override {
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -89,6 +107,10 @@ struct PreampMKII : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do
+    if (is_idle())
+      return;
+
     // read the bypass button values
     int enable_pedal = (int) floor(params[BYPASS_PARAM].getValue());
 
@@ -104,7 +126,7 @@ struct PreampMKII : RRModule {
     }
 
     // bypass (or enable) the pedal
-    midi_out.sendCachedCC(bypass, 102);
+    midi_out.sendCachedCCNow(bypass, 102);
 
     // read the three-way arcade buttons values
     int jump_arcade = (int) floor(params[JUMP_ARCADE_PARAM].getValue());
@@ -114,11 +136,11 @@ struct PreampMKII : RRModule {
     int fuzz_arcade = (int) floor(params[FUZZ_ARCADE_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(jump_arcade, 22);
-    midi_out.sendCachedCC(mids_arcade, 23);
-    midi_out.sendCachedCC(q_arcade, 24);
-    midi_out.sendCachedCC(diode_arcade, 25);
-    midi_out.sendCachedCC(fuzz_arcade, 26);
+    midi_out.sendCachedCCNow(jump_arcade, 22);
+    midi_out.sendCachedCCNow(mids_arcade, 23);
+    midi_out.sendCachedCCNow(q_arcade, 24);
+    midi_out.sendCachedCCNow(diode_arcade, 25);
+    midi_out.sendCachedCCNow(fuzz_arcade, 26);
 
     // check if the preset button was pressed
     // protect it from being spammed by limiting it
@@ -129,73 +151,31 @@ struct PreampMKII : RRModule {
       midi_out.incrementProgram(1, 30);
 
       // start the preset change grace period
-      gettimeofday(&preset_change_grace_period, NULL);
+      preset_change_grace_period = curr_time;
     }
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the the user.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // slider values
-    int volume = (int) std::round(params[VOLUME_SLIDER_PARAM].getValue());
-    int treble = (int) std::round(params[TREBLE_SLIDER_PARAM].getValue());
-    int mids = (int) std::round(params[MIDS_SLIDER_PARAM].getValue());
-    int freq = (int) std::round(params[FREQ_SLIDER_PARAM].getValue());
-    int bass = (int) std::round(params[BASS_SLIDER_PARAM].getValue());
-    int gain = (int) std::round(params[GAIN_SLIDER_PARAM].getValue());
-
-    // read cv voltages and override the values obtained from sliders positions
-    // clamp down the cv value to be between 0 and the value of the slider
-    if (inputs[VOLUME_SLIDER_INPUT].isConnected()) {
-      int volume_cv = convertCVtoCC(inputs[VOLUME_SLIDER_INPUT].getVoltage());
-      volume = clamp(volume_cv, 0, volume);
-    }
-    if (inputs[TREBLE_SLIDER_INPUT].isConnected()) {
-      int treble_cv = convertCVtoCC(inputs[TREBLE_SLIDER_INPUT].getVoltage());
-      treble = clamp(treble_cv, 0, treble);
-    }
-    if (inputs[MIDS_SLIDER_INPUT].isConnected()) {
-      int mids_cv = convertCVtoCC(inputs[MIDS_SLIDER_INPUT].getVoltage());
-      mids = clamp(mids_cv, 0, mids);
-    }
-    if (inputs[FREQ_SLIDER_INPUT].isConnected()) {
-      int freq_cv = convertCVtoCC(inputs[FREQ_SLIDER_INPUT].getVoltage());
-      freq = clamp(freq_cv, 0, freq);
-    }
-    if (inputs[BASS_SLIDER_INPUT].isConnected()) {
-      int bass_cv = convertCVtoCC(inputs[BASS_SLIDER_INPUT].getVoltage());
-      bass = clamp(bass_cv, 0, bass);
-    }
-    if (inputs[GAIN_SLIDER_INPUT].isConnected()) {
-      int gain_cv = convertCVtoCC(inputs[GAIN_SLIDER_INPUT].getVoltage());
-      gain = clamp(gain_cv, 0, gain);
-    }
+    // assign values from sliders (or cv)
+    send_knob_ccs(KNOBS);
 
-    // assign values from knobs (or cv)
-    midi_out.sendCachedCC(volume, 14);
-    midi_out.sendCachedCC(treble, 15);
-    midi_out.sendCachedCC(mids, 16);
-    midi_out.sendCachedCC(freq, 17);
-    midi_out.sendCachedCC(bass, 18);
-    midi_out.sendCachedCC(gain, 19);
-
-    // read the expresion input if it is connected and clamp it between 0-127
-    int expr = -1;
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-
-      // assign value for expression
-      if (expr > 0)
-        midi_out.sendCachedCC(expr, 100);
-    }
+    // assign value for expression
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
 };
 
-struct PreampMKIIWidget : ModuleWidget {
+constexpr RRKnobCC PreampMKII::KNOBS[];
+
+struct PreampMKIIWidget : RRModuleWidget {
   PreampMKIIWidget(PreampMKII* module) {
     setModule(module);
 
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "plugin.hpp"
+#include "core/rr_link.hpp"
+#include "core/rr_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace rack {
+
+// driver id of the loopback driver ("RR"), far away from Rack's own drivers
+static const int RR_LOOPBACK_DRIVER_ID = 0x5252;
+static const int RR_LOOPBACK_DEVICES = 4;
+
+// one message as it reached the loopback device
+struct RRLoopbackEvent {
+  // engine frame the message was generated on
+  int64_t frame;
+  // wall clock time it was sent
+  double time;
+  uint8_t bytes[3];
+  uint8_t size;
+  // time until it arrived at the pedal through the DIN link model,
+  // 0 without the model and -1 if the interface dropped it
+  float linkDelay;
+};
+
+// what the DIN link model of a loopback device saw so far
+struct RRLoopbackLinkStats {
+  bool enabled = false;
+  int bufferSize = 0;
+  uint64_t messages = 0;
+  uint64_t drops = 0;
+  // seconds
+  double avgDelay = 0.0;
+  double maxDelay = 0.0;
+};
+
+// delivers everything sent to the loopback device to its subscribed
+// inputs (e.g. a MIDI-CC module), as if it came in over a cable
+struct RRLoopbackInputDevice : midi::InputDevice {
+  int id;
+  std::string getName() override {
+    return string::f("RobRichards loopback %d", id + 1);
+  }
+};
+
+// a virtual MIDI device that captures the byte stream instead of sending
+// it to hardware. outputs of other plugins can select it as well and send
+// from their audio threads, so the capture ring is lock-free with any
+// number of senders.
+//
+// the messages are delivered to the input device right away, unless the
+// DIN link model is on: then they are serialized at wire speed behind a
+// limited interface buffer and a delivery thread hands them over once
+// their last byte would have reached the pedal. only then do the senders
+// take linkMutex.
+struct RRLoopbackOutputDevice : midi::OutputDevice {
+  int id;
+  RRLoopbackInputDevice* input;
+
+  RRMpscRing<RRLoopbackEvent, 16384> capture;
+  std::atomic<uint64_t> captured{0};
+  // dropped because nobody drained the capture ring
+  std::atomic<uint64_t> dropped{0};
+
+  // guards the link model and the messages on the wire
+  std::mutex linkMutex;
+  RRDinLink link;
+  std::atomic<bool> linkEnabled{false};
+  // messages on the wire, in order of arrival
+  std::deque<std::pair<double, midi::Message>> inFlight;
+  std::thread linkThread;
+  std::atomic<bool> linkRunning{false};
+
+  ~RRLoopbackOutputDevice() {
+    stopLinkThread();
+  }
+
+  std::string getName() override {
+    return string::f("RobRichards loopback %d", id + 1);
+  }
+
+  void sendMessage(const midi::Message& message) override {
+    double now = system::getTime();
+    double delay = 0.0;
+    bool delivered = true;
+    bool queued = false;
+    if (linkEnabled) {
+      std::lock_guard<std::mutex> lock(linkMutex);
+      if (linkEnabled) {
+        queued = true;
+        delivered = link.transmit(now, message.getSize(), &delay);
+        if (delivered) {
+          // stamped with the frame of its arrival when it is delivered
+          midi::Message m = message;
+          m.setFrame(-1);
+          inFlight.push_back(std::make_pair(now + delay, m));
+        }
+      }
+    }
+
+    RRLoopbackEvent event;
+    event.frame = message.getFrame();
+    event.time = now;
+    event.size = std::min(message.getSize(), 3);
+    for (int i = 0; i < event.size; i++)
+      event.bytes[i] = message.bytes[i];
+    event.linkDelay = delivered ? delay : -1.f;
+    if (capture.push(event))
+      captured++;
+    else
+      dropped++;
+
+    if (!queued)
+      input->onMessage(message);
+  }
+
+  // hands over everything captured so far
+  size_t drain(std::vector<RRLoopbackEvent>* events) {
+    size_t count = 0;
+    RRLoopbackEvent event;
+    while (capture.shift(&event)) {
+      events->push_back(event);
+      count++;
+    }
+    return count;
+  }
+
+  void setLink(bool enabled, int bufferSize) {
+    {
+      std::lock_guard<std::mutex> lock(linkMutex);
+      link.buffer_size = bufferSize;
+      if (enabled == linkEnabled)
+        return;
+      linkEnabled = enabled;
+      link.busy_until = 0.0;
+    }
+
+    if (enabled)
+      startLinkThread();
+    else
+      stopLinkThread();
+  }
+
+  RRLoopbackLinkStats getLinkStats() {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    RRLoopbackLinkStats stats;
+    stats.enabled = linkEnabled;
+    stats.bufferSize = link.buffer_size;
+    stats.messages = link.messages;
+    stats.drops = link.drops;
+    stats.avgDelay = link.avg_delay();
+    stats.maxDelay = link.delay_max;
+    return stats;
+  }
+
+  void resetLinkStats() {
+    std::lock_guard<std::mutex> lock(linkMutex);
+    link.reset_stats();
+  }
+
+  void startLinkThread() {
+    if (linkRunning)
+      return;
+    linkRunning = true;
+    linkThread = std::thread(&RRLoopbackOutputDevice::runLink, this);
+  }
+
+  void stopLinkThread() {
+    if (!linkRunning)
+      return;
+    linkRunning = false;
+    if (linkThread.joinable())
+      linkThread.join();
+
+    // whatever is still on the wire arrives now
+    deliver(INFINITY);
+  }
+
+  void deliver(double now) {
+    std::vector<midi::Message> arrived;
+    {
+      std::lock_guard<std::mutex> lock(linkMutex);
+      while (!inFlight.empty() && inFlight.front().first <= now) {
+        arrived.push_back(inFlight.front().second);
+        inFlight.pop_front();
+      }
+    }
+
+    // outside of the lock, the input device takes its own
+    for (const midi::Message& m : arrived)
+      input->onMessage(m);
+  }
+
+  void runLink() {
+    system::setThreadName("RobRichards link");
+
+    while (linkRunning) {
+      deliver(system::getTime());
+
+      // a byte takes 320us, so this is well within one byte on the wire
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+};
+
+// MIDI driver with a few loopback devices, for capturing and comparing the
+// exact byte streams of the modules on machines without pedals or MIDI
+// interfaces. registered in init(), Rack deletes it on shutdown.
+struct RRLoopbackDriver : midi::Driver {
+  RRLoopbackInputDevice inputs[RR_LOOPBACK_DEVICES];
+  RRLoopbackOutputDevice outputs[RR_LOOPBACK_DEVICES];
+
+  RRLoopbackDriver() {
+    for (int i = 0; i < RR_LOOPBACK_DEVICES; i++) {
+      inputs[i].id = i;
+      outputs[i].id = i;
+      outputs[i].input = &inputs[i];
+    }
+  }
+
+  std::string getName() override {
+    return "RobRichards loopback";
+  }
+
+  std::vector<int> getDeviceIds() {
+    std::vector<int> ids;
+    for (int i = 0; i < RR_LOOPBACK_DEVICES; i++)
+      ids.push_back(i);
+    return ids;
+  }
+
+  bool validDevice(int deviceId) {
+    return deviceId >= 0 && deviceId < RR_LOOPBACK_DEVICES;
+  }
+
+  std::vector<int> getInputDeviceIds() override {
+    return getDeviceIds();
+  }
+
+  int getDefaultInputDeviceId() override {
+    return 0;
+  }
+
+  std::string getInputDeviceName(int deviceId) override {
+    return validDevice(deviceId) ? inputs[deviceId].getName() : "";
+  }
+
+  midi::InputDevice* subscribeInput(int deviceId, midi::Input* input) override {
+    if (!validDevice(deviceId))
+      return NULL;
+    inputs[deviceId].subscribe(input);
+    return &inputs[deviceId];
+  }
+
+  void unsubscribeInput(int deviceId, midi::Input* input) override {
+    if (validDevice(deviceId))
+      inputs[deviceId].unsubscribe(input);
+  }
+
+  std::vector<int> getOutputDeviceIds() override {
+    return getDeviceIds();
+  }
+
+  int getDefaultOutputDeviceId() override {
+    return 0;
+  }
+
+  std::string getOutputDeviceName(int deviceId) override {
+    return validDevice(deviceId) ? outputs[deviceId].getName() : "";
+  }
+
+  midi::OutputDevice* subscribeOutput(int deviceId, midi::Output* output) override {
+    if (!validDevice(deviceId))
+      return NULL;
+    outputs[deviceId].subscribe(output);
+    return &outputs[deviceId];
+  }
+
+  void unsubscribeOutput(int deviceId, midi::Output* output) override {
+    if (validDevice(deviceId))
+      outputs[deviceId].unsubscribe(output);
+  }
+};
+
+}
+
+// the loopback driver, defined in plugin.cpp
+extern RRLoopbackDriver* rrLoopbackDriver;
@@ -1,87 +1,365 @@
 #pragma once
 
 #include <midi.hpp>
+#include "core/rr_cc.hpp"
+#include "core/rr_scheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
 namespace rack {
 
-struct RRMidiOutput : dsp::MidiGenerator<PORT_MAX_CHANNELS>, midi::Output {
-  int lastMidiCCValues[128];
-  int currProgram;
+// one per MIDI device, shared by every module that talks to it. its thread
+// is the only one that calls into the driver: it polls the modules' rings
+// round-robin (so the intake never blocks the audio threads), paces the
+// bytes to the wire rate and interleaves the modules fairly. the
+// scheduling itself is in core/rr_scheduler.hpp.
+struct RRMidiAggregator : RRMidiScheduler {
+  int driverId;
+  int deviceId;
+  midi::Output output;
+
+  // guards the scheduler
+  std::mutex mutex;
+
+  // the settings were chosen by one of the modules
+  bool configured = false;
+
+  std::thread thread;
+  std::atomic<bool> running{true};
+  Context* context;
+
+  RRMidiAggregator(int driverId, int deviceId) {
+    this->driverId = driverId;
+    this->deviceId = deviceId;
+
+    // every message already carries its module's channel
+    output.setDriverId(driverId);
+    output.setDeviceId(deviceId);
+    output.channel = -1;
+
+    // the thread needs the same Rack context as the engine
+    context = contextGet();
+    thread = std::thread(&RRMidiAggregator::run, this);
+  }
+
+  ~RRMidiAggregator() {
+    running = false;
+    thread.join();
+    output.setDeviceId(-1);
+  }
+
+  void addQueue(RRMidiQueue* queue) {
+    std::lock_guard<std::mutex> lock(mutex);
+    RRMidiScheduler::addQueue(queue);
+  }
+
+  void removeQueue(RRMidiQueue* queue) {
+    std::lock_guard<std::mutex> lock(mutex);
+    RRMidiScheduler::removeQueue(queue);
+  }
+
+  int getShareCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queues.size();
+  }
+
+  RRMidiDeviceStats getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return RRMidiScheduler::getStats();
+  }
+
+  void resetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    RRMidiScheduler::resetStats();
+  }
+
+  void setRate(float rate) {
+    std::lock_guard<std::mutex> lock(mutex);
+    RRMidiScheduler::setRate(rate, system::getTime());
+    configured = true;
+  }
+
+  float getRate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rate;
+  }
+
+  void setBreakerMode(int mode) {
+    std::lock_guard<std::mutex> lock(mutex);
+    breakerMode = mode;
+    configured = true;
+  }
+
+  int getBreakerMode() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return breakerMode;
+  }
+
+  void run() {
+    contextSet(context);
+    system::setThreadName("RobRichards MIDI");
+
+    while (running) {
+      double wakeup;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        // messages are released one block late
+        engine::Engine* engine = APP->engine;
+        setTiming(engine->getBlockFrame(), engine->getBlockTime(), engine->getSampleTime(), engine->getBlockDuration());
+
+        // wake up at least every millisecond to pick up new messages
+        wakeup = poll(system::getTime(), 0.001);
+      }
+
+      double delay = wakeup - system::getTime();
+      if (delay > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+    }
+  }
+
+  void send(const uint8_t* bytes, int size, int64_t frame) override {
+    midi::Message m;
+    m.setSize(size);
+    for (int i = 0; i < size; i++)
+      m.bytes[i] = bytes[i];
+    m.setFrame(frame);
+    output.sendMessage(m);
+  }
+
+  static std::mutex& registryMutex() {
+    static std::mutex registryMutex;
+    return registryMutex;
+  }
+
+  static std::map<std::pair<int, int>, std::weak_ptr<RRMidiAggregator>>& registry() {
+    static std::map<std::pair<int, int>, std::weak_ptr<RRMidiAggregator>> registry;
+    return registry;
+  }
+
+  static std::shared_ptr<RRMidiAggregator> get(int driverId, int deviceId) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    std::weak_ptr<RRMidiAggregator>& entry = registry()[std::make_pair(driverId, deviceId)];
+    std::shared_ptr<RRMidiAggregator> aggregator = entry.lock();
+    if (!aggregator) {
+      aggregator = std::make_shared<RRMidiAggregator>(driverId, deviceId);
+      entry = aggregator;
+    }
+    return aggregator;
+  }
+
+  static int getShareCount(int driverId, int deviceId) {
+    std::shared_ptr<RRMidiAggregator> aggregator;
+    {
+      std::lock_guard<std::mutex> lock(registryMutex());
+      auto it = registry().find(std::make_pair(driverId, deviceId));
+      if (it != registry().end())
+        aggregator = it->second.lock();
+    }
+    return aggregator ? aggregator->getShareCount() : 0;
+  }
+};
+
+// the CC cache (see core/rr_cc.hpp) on top of a Rack MIDI output
+struct RRMidiOutput : midi::Output, RRCCCache {
+  // program selected whenever a device is attached (-1 for none)
+  int initialProgram = -1;
+
+  // last value given to setClock()
+  bool clk;
+
+  // engine frame of the current process() call
+  int64_t frame = 0;
+
+  // CCs that go in the priority lane (bypass, transport, ...)
+  bool priorityCCs[128];
+
+  // wire rate in bytes per second (0 means unlimited)
+  float byteRate = 0.f;
+
+  // running status breaker strategy of the device
+  int breakerMode = RRMidiScheduler::BREAKER_ALWAYS;
+
+  // messages and their bytes (before running status) queued so far
+  uint64_t queuedMessages = 0;
+  uint64_t queuedBytes = 0;
+
+  // outgoing messages, drained by the aggregator of our device
+  RRMidiQueue txQueue;
+  std::shared_ptr<RRMidiAggregator> aggregator;
+
+  // set by the UI thread when the device changed, the audio thread
+  // resets the cache (see applyReset()) as it owns the staging table
+  std::atomic<bool> resetPending{false};
+  // an aggregator drains txQueue, messages are dropped until then
+  std::atomic<bool> attached{false};
+  // the txQueue generation the audio thread caught up with, stamped
+  // on every message. only touched by the audio thread.
+  uint32_t generation = 0;
 
   RRMidiOutput() {
     reset();
+
+    for (int n = 0; n < 128; n++)
+      priorityCCs[n] = false;
+
+    // bypass on all the pedals
+    setPriorityCC(102);
+    setPriorityCC(103);
+  }
+
+  ~RRMidiOutput() {
+    setAggregator(NULL);
+  }
+
+  void enqueue(uint8_t status, uint8_t data1, uint8_t data2, uint8_t size, bool dummy = false, int lsb = -1) override {
+    // nobody would drain the ring
+    if (!attached)
+      return;
+
+    // the aggregator is shared with other modules, stamp our channel
+    if (status < 0xf0)
+      status |= std::max(channel, 0) & 0x0f;
+
+    RRMidiMessage msg;
+    msg.frame = frame;
+    msg.bytes[0] = status;
+    msg.bytes[1] = data1 & 0x7f;
+    msg.bytes[2] = data2 & 0x7f;
+    msg.size = size;
+    msg.dummy = dummy;
+    msg.lsb = lsb;
+    msg.slot = isLSB(msg.bytes[1]) ? msg.bytes[1] - 32 : msg.bytes[1];
+    msg.generation = generation;
+    // only CCs can be continuous, everything else keeps its order
+    msg.priority = (status & 0xf0) != 0xb0 || priorityCCs[data1 & 0x7f];
+    txQueue.push(msg);
+
+    // the dummy and the LSB are full 3 byte messages of their own
+    queuedMessages += 1 + dummy + (lsb >= 0);
+    queuedBytes += size + (dummy ? 3 : 0) + (lsb >= 0 ? 3 : 0);
   }
 
   void reset() {
-    // clean up the cache of CC values
-    for (int n = 0; n < 128; n++) {
-      lastMidiCCValues[n] = -1;
-    }
+    resetCache();
     currProgram = -1;
-    MidiGenerator::reset();
+    clk = false;
+  }
+
+  // called by the audio thread at the start of every process()
+  void applyReset() {
+    if (!resetPending.exchange(false))
+      return;
+    reset();
+
+    // from here on the messages are meant for the new device
+    generation = txQueue.generation;
+
+    // the new device starts out on the initial program
+    if (initialProgram >= 0 && attached)
+      setProgram(initialProgram);
   }
 
-  void onMessage(const midi::Message& message) override {
-    midi::Output::sendMessage(message);
+  void setInitialProgram(int value) {
+    initialProgram = value;
   }
 
   void setDeviceId(int id) override {
     // only update the channel if it changed
     if (deviceId != id) {
       midi::Output::setDeviceId(id);
-      std::string dev_name = getDeviceName(id);
-      reset();
+
+      // hand our queue to the aggregator of the new device
+      setAggregator(deviceId > -1 ? RRMidiAggregator::get(driverId, deviceId) : NULL);
+    }
+  }
+
+  void setAggregator(std::shared_ptr<RRMidiAggregator> aggregator) {
+    attached = false;
+    if (this->aggregator)
+      this->aggregator->removeQueue(&txQueue);
+
+    // the old aggregator let go of the ring, nothing in it was meant
+    // for the new device. we are its only consumer until it's handed on.
+    while (!txQueue.ring.empty())
+      txQueue.ring.shift();
+
+    // the audio thread may have checked attached just before we cleared
+    // it. until it picks up the reset below, whatever it queues was meant
+    // for the old device and the new aggregator drops it.
+    txQueue.generation++;
+
+    this->aggregator = aggregator;
+    if (aggregator) {
+      aggregator->addQueue(&txQueue);
+      attached = true;
+
+      // share the settings with the other modules on this device
+      if (aggregator->configured) {
+        byteRate = aggregator->getRate();
+        breakerMode = aggregator->getBreakerMode();
+      } else {
+        aggregator->setRate(byteRate);
+        aggregator->setBreakerMode(breakerMode);
+      }
     }
+
+    // everything has to go out again to the new device
+    resetPending = true;
   }
 
-  void resetCCCache(int cc) {
-    lastMidiCCValues[cc] = -1;
+  void setByteRate(float rate) {
+    byteRate = rate;
+    if (aggregator)
+      aggregator->setRate(rate);
   }
 
-  int getCachedCCValue(int cc) {
-    return lastMidiCCValues[cc];
+  void setBreakerMode(int mode) {
+    breakerMode = mode;
+    if (aggregator)
+      aggregator->setBreakerMode(mode);
   }
 
-  bool active() {
-    return deviceId > -1 && channel > -1;
+  // messages this output queued that have not gone out yet
+  size_t getBacklog() {
+    return txQueue.ring.size() + txQueue.continuousBacklog;
   }
 
-  bool sendCachedCC(int value, int cc) {
-    // check the cache for cc messages
-    if (value == lastMidiCCValues[cc]) {
-      return false;
-    }
-    lastMidiCCValues[cc] = value;
+  int64_t getSavedBytes() {
+    return aggregator ? (int64_t) aggregator->savedBytes : 0;
+  }
 
-    // send the CC midi message
-    bool ret = sendCC(value, cc);
+  RRMidiDeviceStats getDeviceStats() {
+    return aggregator ? aggregator->getStats() : RRMidiDeviceStats();
+  }
 
-    // follow up with a dummy message
-    sendDummyMessage();
-    return ret;
+  void resetDeviceStats() {
+    if (aggregator)
+      aggregator->resetStats();
   }
 
-  bool sendCachedCCNoDummy(int value, int cc) {
-    // check the cache for cc messages
-    if (value == lastMidiCCValues[cc]) {
-      return false;
-    }
-    lastMidiCCValues[cc] = value;
+  int getShareCount() {
+    return aggregator ? aggregator->getShareCount() : 0;
+  }
 
-    // send the CC midi message
-    return sendCC(value, cc);
+  void setPriorityCC(int cc) {
+    priorityCCs[cc] = true;
+  }
+
+
+  bool active() {
+    return deviceId > -1 && channel > -1;
   }
 
   bool sendCC(int value, int cc) {
     // send CC message
-    midi::Message m;
-    m.setStatus(0xb);
-    m.setNote(cc);
-    m.setValue(value);
-    sendMessage(m);
-
+    enqueue(0xb0, cc, value, 3);
     return true;
   }
 
@@ -90,47 +368,20 @@ struct RRMidiOutput : dsp::MidiGenerator<PORT_MAX_CHANNELS>, midi::Output {
     // the CBA pedals don't understand to invalidate
     // MIDI's Running Status feature that causes CBA
     // pedals to drop consecutive messages.
-    midi::Message m2;
-    m2.setStatus(0x8);
-    m2.setNote(64);
-    m2.setValue(1);
-    sendMessage(m2);
-  }
-
-  void incrementProgram(int incrby, int max) {
-    // incr the current program modded by the upper limit
-    if (currProgram == max)
-      currProgram = 0;
-    int value = (currProgram + incrby) % max;
-    setProgram(value);
-  }
-
-  void decrementProgram(int decrby, int max) {
-    // decr the current program modded by the upper limit
-    if (currProgram == 0)
-      currProgram = max;
-    int value = (currProgram - decrby) % max;
-    setProgram(value);
-  }
-
-  bool setProgram(int value) {
-    // check the cache to see if we are already on this program
-    if (currProgram == value) {
-      return false;
-    } else {
-      currProgram = value;
-    }
+    enqueue(0x80, 64, 1, 3);
+  }
 
-    // send a Program change message (2 bytes) with -
-    // 0x0c as the status byte
-    midi::Message m;
-    m.setSize(2);
-    m.setStatus(0xc);
-    m.setNote(value);
-    DEBUG("Preamp MKII program change: %d", value);
-    sendMessage(m);
-    return true;
+  void setFrame(int64_t frame) {
+    this->frame = frame;
   }
+
+  void setClock(bool clk) {
+    // send a clock pulse on the rising edge
+    if (clk && !this->clk)
+      enqueue(0xf8, 0, 0, 1);
+    this->clk = clk;
+  }
+
 };
 
 }
@@ -3,6 +3,7 @@
 #include <app/LedDisplay.hpp>
 #include <app/common.hpp>
 #include <helpers.hpp>
+#include "rr_midi.hpp"
 
 using namespace std;
 
@@ -26,14 +27,16 @@ namespace rack {
 
       ui::Menu* menu = createMenu();
       menu->addChild(createMenuLabel("MIDI driver"));
-      midi::Driver* driver = port->getDriver();
-
-      RRMidiDriverItem* item = new RRMidiDriverItem;
-      item->port = port;
-      item->driverId = port->getDriverId();
-      item->text = driver->getName();
-      item->rightText = CHECKMARK(item->driverId == port->driverId);
-      menu->addChild(item);
+
+      // every driver Rack knows about (including our loopback driver)
+      for (int driverId : midi::getDriverIds()) {
+	RRMidiDriverItem* item = new RRMidiDriverItem;
+	item->port = port;
+	item->driverId = driverId;
+	item->text = midi::getDriver(driverId)->getName();
+	item->rightText = CHECKMARK(item->driverId == port->driverId);
+	menu->addChild(item);
+      }
     }
     void step() override {
       if (!text.empty() && port && chosenDriverId == port->driverId) {
@@ -62,16 +65,24 @@ namespace rack {
   };
 
   struct RRMidiChannelItem : ui::MenuItem {
-    midi::Port* port;
+    int* target;
     int channel;
     void onAction(const event::Action& e) override {
-      port->channel = channel;
+      *target = channel;
     }
   };
 
   struct RRMidiChannelChoice : LedDisplayChoice {
     midi::Port* port;
+    // the channel that is chosen, the port's own one unless the module
+    // filters the channels itself
+    int* channel = NULL;
     int chosenChannel = -1;
+
+    int* getTarget() {
+      return channel ? channel : &port->channel;
+    }
+
     void onAction(const event::Action& e) override {
       if (!port) {
 	return;
@@ -81,24 +92,32 @@ namespace rack {
       menu->addChild(createMenuLabel("MIDI channel"));
       for (int channel : port->getChannels()) {
 	RRMidiChannelItem* item = new RRMidiChannelItem;
-	item->port = port;
+	item->target = getTarget();
 	item->channel = channel;
 	item->text = port->getChannelName(channel);
-	item->rightText = CHECKMARK(item->channel == port->channel);
+	item->rightText = CHECKMARK(item->channel == *item->target);
 	menu->addChild(item);
       }
     }
     void step() override {
-      if (!text.empty() && port && chosenChannel == port->channel)
+      if (!text.empty() && port && chosenChannel == *getTarget())
 	return;
-      text = port ? port->getChannelName(port->channel) : "Channel 1";
+      text = port ? port->getChannelName(*getTarget()) : "Channel 1";
       if (port)
-	chosenChannel = port->channel;
+	chosenChannel = *getTarget();
     }
   };
 
+  // how many of our modules are talking to a device
+  inline std::string getShareText(int count) {
+    if (count < 2)
+      return "";
+    return string::f(" (%d modules)", count);
+  }
+
   struct RRMidiDeviceChoice : LedDisplayChoice {
     int chosenDeviceId = -1;
+    int chosenShareCount = 0;
     midi::Port* port;
     void onAction(const event::Action& e) override {
       if (!port)
@@ -119,14 +138,18 @@ namespace rack {
 	item->port = port;
 	item->deviceId = deviceId;
 	item->text = port->getDeviceName(deviceId);
+	item->text += getShareText(RRMidiAggregator::getShareCount(port->driverId, deviceId));
 	item->rightText = CHECKMARK(item->deviceId == port->deviceId);
 	menu->addChild(item);
       }
     }
 
     void step() override {
-      // cache the device name until the deviceId changes.
-      if (!text.empty() && port && chosenDeviceId == port->deviceId)
+      // cache the device name until the deviceId or the number
+      // of modules sharing the device changes.
+      RRMidiOutput* output = dynamic_cast<RRMidiOutput*>(port);
+      int shareCount = output ? output->getShareCount() : 0;
+      if (!text.empty() && port && chosenDeviceId == port->deviceId && chosenShareCount == shareCount)
 	return;
 
       text = port ? port->getDeviceName(port->deviceId) : "";
@@ -135,9 +158,11 @@ namespace rack {
 	chosenDeviceId = -1;
 	color.a = 0.5f;
       } else {
+	text += getShareText(shareCount);
 	chosenDeviceId = port->deviceId;
 	color.a = 1.f;
       }
+      chosenShareCount = shareCount;
     }
 
   };
@@ -149,7 +174,7 @@ namespace rack {
     LedDisplaySeparator* deviceSeparator;
     RRMidiChannelChoice* channelChoice;
 
-    void setMidiPort(midi::Port* port) {
+    void setMidiPort(midi::Port* port, int* channel = NULL) {
       clearChildren();
 
       math::Vec pos;
@@ -176,6 +201,7 @@ namespace rack {
       channelChoice = createWidget<RRMidiChannelChoice>(pos);
       channelChoice->box.size.x = box.size.x;
       channelChoice->port = port;
+      channelChoice->channel = channel;
       addChild(channelChoice);
 
     }
@@ -1,59 +1,197 @@
 #pragma once
 
-#include <sys/time.h>
 #include "plugin.hpp"
 #include "rr_midi.hpp"
+#include "core/rr_cc.hpp"
+#include "core/rr_timing.hpp"
+#include "core/rr_knobs.hpp"
+#include "rr_rtcheck.hpp"
 #include <dsp/digital.hpp>
+#include <vector>
 
 using namespace std;
 
 namespace rack {
 
+// runs the schmitt triggers of all of a module's gate inputs, 4 at a time.
+// process() returns a mask with the bit of every input id that went high.
+template <int N>
+struct RRGateBank {
+  static const int LANES = (N + 3) / 4;
+
+  int gate_inputs[LANES * 4];
+  dsp::TSchmittTrigger<simd::float_4> triggers[LANES];
+
+  void config(const int (&ids)[N]) {
+    for (int i = 0; i < LANES * 4; i++)
+      gate_inputs[i] = (i < N) ? ids[i] : -1;
+  }
+
+  uint32_t process(std::vector<engine::Input>& inputs) {
+    uint32_t triggered = 0;
+    for (int l = 0; l < LANES; l++) {
+      // disconnected (and unused) lanes sit between the thresholds,
+      // which holds their trigger state
+      float voltages[4];
+      for (int i = 0; i < 4; i++) {
+        int id = gate_inputs[l * 4 + i];
+        voltages[i] = (id >= 0 && inputs[id].isConnected()) ? inputs[id].getVoltage() : 1.f;
+      }
+
+      // low below 0.1V, high above 2V
+      int rising = simd::movemask(triggers[l].process(simd::float_4::load(voltages), 0.1f, 2.f));
+      for (int i = 0; rising; i++, rising >>= 1) {
+        if (rising & 1)
+          triggered |= 1u << gate_inputs[l * 4 + i];
+      }
+    }
+    return triggered;
+  }
+};
+
 struct RRModule : Module {
   // MIDI controller
   RRMidiOutput midi_out;
 
   // rate limiting
-  float rate_limiter_phase = 0.f;
-
-  // tap tempo variables
-  bool can_tap_tempo = true;
-  struct timeval last_tap_tempo_time;
-  double next_blink_usec = 0;
-  double next_blink_sec = 0;
-  bool start_blinking = false;
-  bool first_tap = false;
-  double curr_rate_sec = 0;
-  double curr_rate_usec = 0;
-  float next_brightness = 0.f;
+  RRRateLimiter rate_limiter;
+
+  // control rate of the module and its CCs (see core/rr_timing.hpp),
+  // the rate limiter ticks at control_clock.tick
+  RRControlClock control_clock;
+
+  // load guard, widens the control periods (by the clock's load factor)
+  // while the module gets too expensive or the MIDI backlog grows, and
+  // narrows them again once the load dropped. off by default, it times
+  // process().
+  static const int MAX_LOAD_FACTOR = 8;
+  bool load_guard = false;
+  // share of a control tick's time the module may spend in process()
+  float load_budget = 0.02f;
+  size_t backlog_budget = 64;
+  // smoothed cost (in seconds) of all the process() calls of a control
+  // tick, only one tick in 8 is measured
+  float load_cost = 0.f;
+  size_t load_backlog = 0;
+  double load_window_cost = 0.0;
+  double load_window_end = 0.0;
+  double load_next_window = 0.0;
+  double load_next_check = 0.0;
+  double load_next_recover = 0.0;
+
+  // the module's knob table, for the context menu
+  const RRKnobCC* knob_ccs = NULL;
+  size_t num_knob_ccs = 0;
+
+  // monotonic timebase (in seconds). it is advanced by the engine's
+  // sample time on every process() call so that timers never have to
+  // read the wall clock and keep their duration across sample rate changes.
+  double curr_time = 0.0;
+
+  // tap tempo and LED flashing
+  RRTapTempo tap_tempo;
+  RRLedFlasher led_flasher;
+
+  // change detection, snapshots of the params and inputs (INFINITY
+  // when disconnected) as of the last process() call
+  std::vector<float> param_snapshot;
+  std::vector<float> input_snapshot;
+
+  // peak tracking of the CV inputs across the samples the rate limiter
+  // skips, so that short transients are not lost (see decimated_cv())
+  std::vector<RRCVWindow> input_windows;
+  uint32_t midi_cache_version = 0;
+  // something changed that the next control block still has to handle
+  bool controls_pending = true;
+
+  // knob to CC conversion, hysteresis and thinning (see core/rr_knobs.hpp)
+  RRKnobBank knob_bank;
 
   // random things
   bool lights_off = true;
 
-  // periodic internal clock processing
-  dsp::ClockDivider enable_midi_clk;
-
   RRModule() {
-    // get the current time, this is so we can keep throttle tap
-    // tempo messages.
-    gettimeofday(&last_tap_tempo_time, NULL);
+    // tap tempo timing can't wait behind the knobs
+    midi_out.setPriorityCC(93);
+  }
+
+  // the pedal's own processing, process() wraps it with the real-time
+  // scope and the load guard
+  virtual void process_pedal(const ProcessArgs& args) {}
+
+  void process(const ProcessArgs& args) override {
+    // no allocations, locks or syscalls from here on (see rr_rtcheck.hpp)
+    RR_REALTIME_SCOPE(model ? model->slug.c_str() : "module");
 
-    // keep an internal clock to re-enable the midi clock (~every 6s)
-    enable_midi_clk.setDivision(524288);
+    if (load_guard) {
+      process_measured(args);
+      return;
+    }
+
+    process_pedal(args);
   }
 
-  bool should_rate_limit(const float period, float sample_time) {
-    rate_limiter_phase += sample_time / period;
-    if (rate_limiter_phase >= 1.f) {
-      // no rate limiting needed, reduce the phase by 1
-      rate_limiter_phase -= 1.f;
-      return false;
-    } else {
-      // apply rate limiting
-      return true;
+  void advance_timebase(const ProcessArgs& args) {
+    curr_time += args.sampleTime;
+
+    // pick up a device change from the UI thread
+    midi_out.applyReset();
+
+    // stamp outgoing MIDI messages with the frame they were generated on
+    midi_out.setFrame(args.frame);
+  }
+
+  template <size_t N>
+  void config_knobs(const RRKnobCC (&knobs)[N]) {
+    knob_ccs = knobs;
+    num_knob_ccs = N;
+
+    // config() is done, size the snapshots here rather than on the
+    // audio thread
+    size_snapshots();
+  }
+
+  void size_snapshots() {
+    param_snapshot.assign(params.size(), NAN);
+    input_snapshot.assign(inputs.size(), NAN);
+    input_windows.assign(inputs.size(), RRCVWindow());
+    controls_pending = true;
+  }
+
+  void update_load_guard() {
+    if (!load_guard) {
+      control_clock.set_load_factor(1);
+      return;
+    }
+
+    // give every change some time to show before the next one
+    if (curr_time < load_next_check)
+      return;
+    load_next_check = curr_time + 0.25;
+
+    load_backlog = midi_out.getBacklog();
+    int load_factor = control_clock.load_factor;
+    float budget = load_budget * control_clock.tick;
+    if (load_cost > budget || load_backlog > backlog_budget) {
+      // over budget, back off
+      control_clock.set_load_factor((load_factor < MAX_LOAD_FACTOR) ? load_factor * 2 : MAX_LOAD_FACTOR);
+      load_next_recover = curr_time + 1.0;
+    } else if (load_factor > 1 && curr_time >= load_next_recover
+               && load_cost < budget / 2 && load_backlog < backlog_budget / 2) {
+      // comfortably under budget for a while, recover one step
+      control_clock.set_load_factor(load_factor / 2);
+      load_next_recover = curr_time + 1.0;
     }
   }
 
+  bool cc_due(int cc) {
+    return control_clock.cc_due(cc, curr_time);
+  }
+
+  bool should_rate_limit(const float period, float sample_time) {
+    return rate_limiter.process(period, sample_time);
+  }
+
   bool disable_module() {
     bool was_disabled = lights_off;
     lights_off = true;
@@ -64,9 +202,87 @@ struct RRModule : Module {
     lights_off = false;
   }
 
+  // compares every param and input against its snapshot, once per sample.
+  // that is O(params + inputs), a few dozen loads and compares for these
+  // panels, and the input loop has to run per sample anyway to keep the
+  // decimation windows (RRCVWindow) from missing short peaks.
+  bool controls_changed() {
+    // in case the module didn't call config_knobs()
+    if (param_snapshot.size() != params.size() || input_snapshot.size() != inputs.size())
+      size_snapshots();
+
+    for (size_t i = 0; i < params.size(); i++) {
+      float value = params[i].getValue();
+      if (value != param_snapshot[i]) {
+        param_snapshot[i] = value;
+        controls_pending = true;
+      }
+    }
+    for (size_t i = 0; i < inputs.size(); i++) {
+      float value = inputs[i].isConnected() ? inputs[i].getVoltage() : INFINITY;
+      if (value != input_snapshot[i]) {
+        input_snapshot[i] = value;
+        controls_pending = true;
+      }
+
+      // widen the decimation window, a disconnected input empties it
+      input_windows[i].add(value);
+    }
+
+    // cached CC values were dropped, they have to go out again
+    if (midi_out.cacheVersion != midi_cache_version) {
+      midi_cache_version = midi_out.cacheVersion;
+      controls_pending = true;
+    }
+
+    // stays set until a control block ran (see controls_done())
+    return controls_pending;
+  }
+
+  void controls_done() {
+    // CCs that were not due yet keep the control blocks running
+    controls_pending = control_clock.waiting();
+    update_load_guard();
+  }
+
+  // times process_pedal() for the load guard. every call of one control
+  // tick in 8 is timed, the skipped samples cost as much as the blocks.
+  void process_measured(const ProcessArgs& args) {
+    if (load_window_end == 0.0 && curr_time < load_next_window) {
+      process_pedal(args);
+      return;
+    }
+    if (load_window_end == 0.0)
+      load_window_end = curr_time + control_clock.tick;
+
+    double start = system::getTime();
+    process_pedal(args);
+    load_window_cost += system::getTime() - start;
+
+    if (curr_time >= load_window_end) {
+      load_cost += ((float) load_window_cost - load_cost) * 0.1f;
+      load_window_cost = 0.0;
+      load_window_end = 0.0;
+      load_next_window = curr_time + control_clock.tick * 7;
+    }
+  }
+
+  // modules with running timers (grace periods, held buttons, timeouts)
+  // override this so that the idle fast path doesn't freeze them. LEDs
+  // that only blink don't count, modules keep them moving with
+  // blink_tap_tempo() or flash_led() before they return idle.
+  virtual bool timers_idle() {
+    return true;
+  }
+
+  bool is_idle() {
+    // nothing moved, no timers are running and no thinned CC is waiting
+    return !controls_changed() && timers_idle() && !knob_bank.thin_pending;
+  }
+
   void process_midi_clock(bool enable_clock) {
       // turn on midi clock (just in case it is off)
-      midi_out.sendCachedCC(127, 51);
+      midi_out.sendCachedCCNow(127, 51);
 
       // send a clock pulse
       midi_out.setClock(enable_clock);
@@ -76,124 +292,63 @@ struct RRModule : Module {
     midi_out.resetCCCache(51);
   }
 
-  float process_tap_tempo(int tap_tempo) {
-    float ret_brightness = -1.f;
-
-    // if the tap tempo button was pressed, force a midi message to be sent
-    if (can_tap_tempo && tap_tempo) {
-      // we are allowing tap tempo actions and they tapped the tempo button
+  float process_tap_tempo(int tap) {
+    // the tap goes out right away, the pedal measures the tempo itself
+    bool tapped;
+    float brightness = tap_tempo.process(tap, curr_time, &tapped);
+    if (tapped)
       midi_out.sendCC(1, 93);
-      can_tap_tempo = false;
-
-      // measure the amount of time from the previous tap tempo to this tap tempo.
-      // this will be the tap tempo rate (for the tap tempo LED).
-      double last_time_usec = (double) last_tap_tempo_time.tv_usec;
-      double last_time_sec = (double) last_tap_tempo_time.tv_sec;
-
-      // get a new measurement
-      struct timeval ctime;
-      gettimeofday(&ctime, NULL);
-      double this_time_usec = (double) ctime.tv_usec;
-      double this_time_sec = (double) ctime.tv_sec;
-
-      // calculate the next time we need to blink (dont allow slower than a 2s rate)
-      next_blink_usec = this_time_usec - last_time_usec;
-      if (next_blink_usec > 1000000)
-        next_blink_usec = 1000000;
-      next_blink_usec /= 2;
-      next_blink_usec += this_time_usec;
-
-      next_blink_sec = this_time_sec  - last_time_sec;
-      if (next_blink_sec > 2)
-        next_blink_sec = 2;
-      next_blink_sec /= 2;
-      next_blink_sec += this_time_sec;
-
-      // update the current time
-      last_tap_tempo_time = ctime;
-
-      // keep track of whether two taps have occurred so far
-      if (!start_blinking && !first_tap) {
-        // first tap occurred
-        first_tap = true;
-      } else if (!start_blinking && first_tap) {
-        // second tap occurred, start blinking the light
-        start_blinking = true;
-        // the next time we blink, turn on the light
-        next_brightness = 1.f;
-      }
+    return brightness;
+  }
 
-      // calculate the blink rate based on the last two taps
-      // if we were told to start blinking
-      if (start_blinking) {
-        curr_rate_sec = next_blink_sec - this_time_sec;
-        curr_rate_usec = next_blink_usec - this_time_usec;
-      }
+  // the tap tempo LED without a tap, for the idle fast path
+  float blink_tap_tempo() {
+    return tap_tempo.blink(curr_time);
+  }
 
-    } else if (tap_tempo) {
-      // they wanted to do a tap tempo, but they did it too fast.
-      // calculate if we are allowed to tap next time
-      struct timeval ctime;
-      gettimeofday(&ctime, NULL);
-
-      // calculate if enough time has elapsed (>100ms)
-      double elapsed = (double)(ctime.tv_usec - last_tap_tempo_time.tv_usec) / 1000000 +
-        (double)(ctime.tv_sec - last_tap_tempo_time.tv_sec);
-      if (elapsed > 0.1)
-        can_tap_tempo = true;
-    } else if (start_blinking) {
-      // no tap tempo button was clicked and we have a stored "next blink time",
-      // determine if we should blink the tempo light right now
-      struct timeval ctime;
-      gettimeofday(&ctime, NULL);
-
-      // if the current time is greater than the next blink time, flash the light.
-      // the next process iteration will turn it off
-      double this_time_usec = (double) ctime.tv_usec;
-      double this_time_sec = (double) ctime.tv_sec;
-      double elapsed_usec = (double) (this_time_usec - next_blink_usec);
-      double elapsed_sec = (double) (this_time_sec - next_blink_sec);
-      double elapsed = (double) ((elapsed_sec) + (elapsed_usec / 1000000));
-      if (elapsed > 0) {
-        // flash the tap tempo light for the active color
-        ret_brightness = next_brightness;
-
-        // flip the brightness value for the next blink
-        next_brightness = !next_brightness;
-
-        // store the current time for the next blink, add rate and
-        // subtract the amount we went over because this accounts for
-        // the drift we may have experienced.
-        next_blink_usec = (this_time_usec + curr_rate_usec) - elapsed_usec;
-        next_blink_sec = (this_time_sec + curr_rate_sec) - elapsed_sec;
-      }
-    }
+  float flash_led(float blink_rate) {
+    return led_flasher.process(blink_rate, curr_time);
+  }
 
-    // return values:
-    //   ret_brightness < 0  --> don't change brightness.
-    //   ret_brightness >= 0 --> change brightness according
-    //                           to the retuned value.
-    return ret_brightness;
+  // the voltage that best represents an input since the last call (see
+  // RRCVWindow). this keeps the control rate low without dropping short peaks.
+  float decimated_cv(int input) {
+    float value = inputs[input].getVoltage();
+    if (input < (int) input_windows.size())
+      value = input_windows[input].take(value);
+    return value;
   }
 
   int convertCVtoCC(float cv) {
     return (int) std::round(cv*2 / 10.f * 127);
   }
 
-  bool should_transition_to_state(float time_until, struct timeval grace_period) {
-    // get a new measurement
-    struct timeval ctime;
-    gettimeofday(&ctime, NULL);
-    double this_time_usec = (double) ctime.tv_usec;
-    double this_time_sec = (double) ctime.tv_sec;
+  template <size_t N>
+  void send_knob_ccs(const RRKnobCC (&knobs)[N]) {
+    knob_bank.send(&midi_out, &control_clock, curr_time, knobs, N,
+      [&](const RRKnobCC& knob, float* value, float* cv) {
+        *value = params[knob.param].getValue();
+        *cv = inputs[knob.input].isConnected() ? decimated_cv(knob.input) : NAN;
+      });
+  }
+
+  // hysteresis for a CV that goes straight onto a CC (clamped between 0-127)
+  int hold_cv_cc(float cv, int cc) {
+    return knob_bank.hold_cv(cv, cc);
+  }
 
+  void send_expression_cc(int input) {
+    // the expression input is clamped between 0-127
+    if (!inputs[input].isConnected() || !cc_due(100))
+      return;
+    int expr = hold_cv_cc(decimated_cv(input), 100);
+    if (expr > 0)
+      midi_out.sendCachedCC(expr, 100);
+  }
+
+  bool should_transition_to_state(float time_until, double grace_period) {
     // calculate whether we should transition to the next state
-    double last_time_usec = (double) grace_period.tv_usec;
-    double last_time_sec = (double) grace_period.tv_sec;
-    double diff_sec = this_time_sec - last_time_sec;
-    double diff_usec = this_time_usec - last_time_usec;
-    float diff = (float) (diff_sec + (diff_usec/1000000));
-    if (diff > time_until) {
+    if (curr_time - grace_period > time_until) {
       // transition to next state
       return true;
     } else {
@@ -202,6 +357,68 @@ struct RRModule : Module {
     }
   }
 
+  json_t* dataToJson() override {
+    json_t* rootJ = json_object();
+    json_object_set_new(rootJ, "midi_byte_rate", json_real(midi_out.byteRate));
+    json_object_set_new(rootJ, "midi_breaker_mode", json_integer(midi_out.breakerMode));
+    json_object_set_new(rootJ, "midi_high_res_ccs", json_boolean(midi_out.highResCCs));
+    json_object_set_new(rootJ, "cv_hysteresis", json_real(knob_bank.cv_hysteresis));
+    json_object_set_new(rootJ, "cc_thin_error", json_real(knob_bank.cc_thin_error));
+    json_object_set_new(rootJ, "control_period", json_real(control_clock.period));
+    json_object_set_new(rootJ, "load_guard", json_boolean(load_guard));
+
+    // only the CCs that override the module's control rate
+    json_t* ccPeriodsJ = json_object();
+    for (int cc = 0; cc < 128; cc++) {
+      if (control_clock.cc_periods[cc] > 0.f)
+        json_object_set_new(ccPeriodsJ, string::f("%d", cc).c_str(), json_real(control_clock.cc_periods[cc]));
+    }
+    json_object_set_new(rootJ, "cc_periods", ccPeriodsJ);
+    return rootJ;
+  }
+
+  void dataFromJson(json_t* rootJ) override {
+    json_t* byteRateJ = json_object_get(rootJ, "midi_byte_rate");
+    if (byteRateJ)
+      midi_out.setByteRate(json_number_value(byteRateJ));
+
+    json_t* breakerModeJ = json_object_get(rootJ, "midi_breaker_mode");
+    if (breakerModeJ)
+      midi_out.setBreakerMode(json_integer_value(breakerModeJ));
+
+    json_t* highResCCsJ = json_object_get(rootJ, "midi_high_res_ccs");
+    if (highResCCsJ)
+      midi_out.highResCCs = json_boolean_value(highResCCsJ);
+
+    json_t* cvHysteresisJ = json_object_get(rootJ, "cv_hysteresis");
+    if (cvHysteresisJ)
+      knob_bank.cv_hysteresis = json_number_value(cvHysteresisJ);
+
+    json_t* ccThinErrorJ = json_object_get(rootJ, "cc_thin_error");
+    if (ccThinErrorJ)
+      knob_bank.cc_thin_error = json_number_value(ccThinErrorJ);
+
+    json_t* controlPeriodJ = json_object_get(rootJ, "control_period");
+    if (controlPeriodJ)
+      control_clock.period = json_number_value(controlPeriodJ);
+
+    json_t* loadGuardJ = json_object_get(rootJ, "load_guard");
+    if (loadGuardJ)
+      load_guard = json_boolean_value(loadGuardJ);
+
+    json_t* ccPeriodsJ = json_object_get(rootJ, "cc_periods");
+    if (ccPeriodsJ) {
+      const char* key;
+      json_t* periodJ;
+      json_object_foreach(ccPeriodsJ, key, periodJ) {
+        int cc = atoi(key);
+        if (cc >= 0 && cc < 128)
+          control_clock.cc_periods[cc] = json_number_value(periodJ);
+      }
+    }
+    control_clock.update_tick();
+  }
+
 };
 
 }
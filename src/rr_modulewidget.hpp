@@ -0,0 +1,158 @@
+#pragma once
+
+#include "plugin.hpp"
+#include "rr_module.hpp"
+
+using namespace std;
+
+namespace rack {
+
+  // wire rates offered in the context menu (bytes per second)
+  static const float RR_MIDI_BYTE_RATES[] = {0.f, 3125.f, 2000.f, 1000.f};
+
+  // CV hysteresis widths offered in the context menu (steps of the
+  // output resolution, a 14-bit step is 1/128 of a 7-bit one)
+  static const float RR_CV_HYSTERESIS[] = {0.f, 0.5f, 1.f, 2.f, 4.f};
+
+  // CC thinning errors offered in the context menu (CC steps)
+  static const float RR_CC_THIN_ERRORS[] = {0.f, 0.5f, 1.f, 2.f};
+
+  // control periods offered in the context menu (seconds)
+  static const float RR_CONTROL_PERIODS[] = {0.001f, 0.002f, 0.005f, 0.01f, 0.02f};
+
+  struct RRModuleWidget : ModuleWidget {
+    static size_t getControlPeriodIndex(float period) {
+      for (size_t i = 0; i < 5; i++) {
+	if (period == RR_CONTROL_PERIODS[i])
+	  return i;
+      }
+      return 2;
+    }
+
+    static void appendCCPeriodItem(ui::Menu* menu, RRModule* rr_module, std::string name, int cc) {
+      // 0 follows the module's control rate
+      menu->addChild(createIndexSubmenuItem(string::f("%s (CC %d)", name.c_str(), cc),
+	{"Module rate", "1 ms", "2 ms", "5 ms", "10 ms", "20 ms"},
+	[=]() {
+	  float period = rr_module->control_clock.cc_periods[cc];
+	  return (period > 0.f) ? getControlPeriodIndex(period) + 1 : (size_t) 0;
+	},
+	[=](size_t i) {
+	  rr_module->control_clock.set_cc_period(cc, (i > 0) ? RR_CONTROL_PERIODS[i - 1] : 0.f);
+	}
+      ));
+    }
+
+    void appendContextMenu(ui::Menu* menu) override {
+      RRModule* rr_module = dynamic_cast<RRModule*>(module);
+      if (!rr_module)
+	return;
+
+      menu->addChild(new ui::MenuSeparator);
+      menu->addChild(createMenuLabel("MIDI"));
+
+      // slow down expression heavy pedals on a tight wire budget
+      menu->addChild(createIndexSubmenuItem("Control rate",
+	{"1 ms", "2 ms", "5 ms", "10 ms", "20 ms"},
+	[=]() {
+	  return getControlPeriodIndex(rr_module->control_clock.period);
+	},
+	[=](size_t i) {
+	  rr_module->control_clock.set_period(RR_CONTROL_PERIODS[i]);
+	}
+      ));
+      // back off while the engine or the wire can't keep up
+      menu->addChild(createBoolPtrMenuItem("Load guard", "", &rr_module->load_guard));
+      if (rr_module->control_clock.load_factor > 1)
+	menu->addChild(createMenuLabel(string::f("Control rate slowed down x%d (%.0f us per tick, %d queued)",
+	  rr_module->control_clock.load_factor, rr_module->load_cost * 1e6f, (int) rr_module->load_backlog)));
+      else
+	menu->addChild(createMenuLabel(string::f("Control rate at full speed (%.0f us per tick, %d queued)",
+	  rr_module->load_cost * 1e6f, (int) rr_module->load_backlog)));
+      // shared device numbers, for finding out how many modules one device takes
+      RRMidiDeviceStats stats = rr_module->midi_out.getDeviceStats();
+      menu->addChild(createMenuLabel(string::f("Device: %d modules, %llu sent, %llu lost",
+	stats.modules, (unsigned long long) stats.sent, (unsigned long long) stats.lost)));
+      menu->addChild(createMenuLabel(string::f("Device latency: %.2f ms hold + %.2f ms queueing avg, %.2f ms max",
+	stats.hold * 1e3, stats.avgQueueing * 1e3, stats.maxQueueing * 1e3)));
+      menu->addChild(createMenuItem("Reset device stats", "",
+	[=]() {
+	  rr_module->midi_out.resetDeviceStats();
+	}
+      ));
+      menu->addChild(createSubmenuItem("Per-CC control rate", "",
+	[=](ui::Menu* menu) {
+	  for (size_t i = 0; i < rr_module->num_knob_ccs; i++) {
+	    const RRKnobCC& knob = rr_module->knob_ccs[i];
+	    appendCCPeriodItem(menu, rr_module, rr_module->paramQuantities[knob.param]->name, knob.cc);
+	  }
+	  appendCCPeriodItem(menu, rr_module, "Expression", 100);
+	}
+      ));
+
+      // pace the output for 5-pin DIN interfaces
+      menu->addChild(createIndexSubmenuItem("Wire rate",
+	{"Unlimited (USB)", "3125 bytes/s (5-pin DIN)", "2000 bytes/s", "1000 bytes/s"},
+	[=]() {
+	  for (size_t i = 0; i < 4; i++) {
+	    if (rr_module->midi_out.byteRate == RR_MIDI_BYTE_RATES[i])
+	      return i;
+	  }
+	  return (size_t) 0;
+	},
+	[=](size_t i) {
+	  rr_module->midi_out.setByteRate(RR_MIDI_BYTE_RATES[i]);
+	}
+      ));
+
+      // always by default, the smart modes opt in to breaking the running
+      // status only when it would really be used
+      menu->addChild(createIndexSubmenuItem("Running status breaker",
+	{"Always", "Smart", "Smart + idle timeout", "Never"},
+	[=]() {
+	  return (size_t) rr_module->midi_out.breakerMode;
+	},
+	[=](size_t i) {
+	  rr_module->midi_out.setBreakerMode(i);
+	}
+      ));
+      menu->addChild(createMenuLabel(string::f("Wire bytes saved: %lld", (long long) rr_module->midi_out.getSavedBytes())));
+
+      // smooth modulation for pedals that take CC n+32 as the LSB
+      menu->addChild(createBoolPtrMenuItem("14-bit knob CCs", "", &rr_module->midi_out.highResCCs));
+
+      // keep jittery CV from flooding the wire
+      menu->addChild(createIndexSubmenuItem("CV hysteresis",
+	{"Off", "0.5 steps", "1 step", "2 steps", "4 steps"},
+	[=]() {
+	  for (size_t i = 0; i < 5; i++) {
+	    if (rr_module->knob_bank.cv_hysteresis == RR_CV_HYSTERESIS[i])
+	      return i;
+	  }
+	  return (size_t) 0;
+	},
+	[=](size_t i) {
+	  rr_module->knob_bank.cv_hysteresis = RR_CV_HYSTERESIS[i];
+	}
+      ));
+
+      // let the pedal's smoothing interpolate between sparse knob CCs
+      menu->addChild(createIndexSubmenuItem("Knob CC thinning",
+	{"Off", "0.5 CC steps", "1 CC step", "2 CC steps"},
+	[=]() {
+	  for (size_t i = 0; i < 4; i++) {
+	    if (rr_module->knob_bank.cc_thin_error == RR_CC_THIN_ERRORS[i])
+	      return i;
+	  }
+	  return (size_t) 0;
+	},
+	[=](size_t i) {
+	  rr_module->knob_bank.cc_thin_error = RR_CC_THIN_ERRORS[i];
+	}
+      ));
+      menu->addChild(createMenuLabel(string::f("Thinned CCs: %lld sent, %lld suppressed",
+	(long long) rr_module->knob_bank.thin_sent, (long long) rr_module->knob_bank.thin_suppressed)));
+    }
+  };
+
+}
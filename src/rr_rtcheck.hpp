@@ -0,0 +1,39 @@
+#pragma once
+
+// real-time safety checking of the audio thread. build the plugin with
+// RT_CHECK=1 and run Rack with the checker (src/rtcheck) preloaded:
+//
+//   RT_CHECK=1 make install && make rtcheck
+//   LD_PRELOAD=build/rtcheck/librrrtcheck.so ./Rack
+//
+// every allocation, lock or blocking syscall inside a real-time scope is
+// then reported on stderr with a backtrace. without RT_CHECK the scopes
+// compile to nothing.
+
+#ifdef RR_RT_CHECK
+
+// defined by the checker, NULL when it isn't preloaded
+extern "C" {
+  void rr_rt_enter(const char* what) __attribute__((weak));
+  void rr_rt_leave() __attribute__((weak));
+}
+
+struct RRRealtimeScope {
+  RRRealtimeScope(const char* what) {
+    if (rr_rt_enter)
+      rr_rt_enter(what);
+  }
+
+  ~RRRealtimeScope() {
+    if (rr_rt_leave)
+      rr_rt_leave();
+  }
+};
+
+#define RR_REALTIME_SCOPE(what) RRRealtimeScope rr_realtime_scope(what)
+
+#else
+
+#define RR_REALTIME_SCOPE(what)
+
+#endif
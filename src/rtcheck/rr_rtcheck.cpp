@@ -0,0 +1,278 @@
+// real-time safety checker, see src/rr_rtcheck.hpp. it is preloaded into
+// Rack and sits in front of the libc calls that have no business on the
+// audio thread. the plugin marks its real-time scopes with rr_rt_enter()
+// and rr_rt_leave(), any of these calls inside a scope is a violation.
+//
+// Linux/glibc only. it doesn't depend on Rack.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+
+// glibc's own allocator, so that the wrappers don't need dlsym()
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+  void __libc_free(void* ptr);
+}
+
+// initial-exec, a lazily allocated TLS block would call malloc itself
+#define RR_TLS __thread __attribute__((tls_model("initial-exec")))
+
+// the scope the thread is in (nesting depth) and what it belongs to
+static RR_TLS int rt_depth = 0;
+static RR_TLS const char* rt_what = NULL;
+// set while reporting, the report itself is allowed to do anything
+static RR_TLS bool rt_reporting = false;
+
+// how many violations get a backtrace, RR_RT_REPORTS overrides it
+static int max_reports = 20;
+// abort on the first violation (RR_RT_ABORT), to catch it in a debugger
+static bool abort_on_violation = false;
+
+static std::atomic<long> violations{0};
+
+static void report(const char* call) {
+  if (rt_depth == 0 || rt_reporting)
+    return;
+  rt_reporting = true;
+
+  long count = ++violations;
+  if (count <= max_reports) {
+    // stderr is unbuffered, fprintf doesn't allocate for it
+    fprintf(stderr, "[rtcheck] %s() on the audio thread in %s (violation %ld)\n",
+      call, rt_what ? rt_what : "?", count);
+    void* frames[32];
+    int depth = backtrace(frames, 32);
+    // skip report() and the wrapper
+    backtrace_symbols_fd(frames + 2, depth - 2, STDERR_FILENO);
+  }
+
+  if (abort_on_violation)
+    abort();
+  rt_reporting = false;
+}
+
+// the next definitions of the wrapped functions. they are all looked up
+// in the constructor, dlsym() allocates and would show up as a violation
+// of whatever scope happened to call a wrapper first.
+static int (*next_pthread_mutex_lock)(pthread_mutex_t*);
+static int (*next_pthread_cond_wait)(pthread_cond_t*, pthread_mutex_t*);
+static int (*next_pthread_rwlock_rdlock)(pthread_rwlock_t*);
+static int (*next_pthread_rwlock_wrlock)(pthread_rwlock_t*);
+static ssize_t (*next_read)(int, void*, size_t);
+static ssize_t (*next_write)(int, const void*, size_t);
+static int (*next_nanosleep)(const struct timespec*, struct timespec*);
+static int (*next_usleep)(useconds_t);
+static int (*next_sched_yield)();
+static int (*next_select)(int, fd_set*, fd_set*, fd_set*, struct timeval*);
+static long (*next_syscall)(long, ...);
+
+template <typename T>
+static void resolve(T* fn, const char* name) {
+  *fn = (T) dlsym(RTLD_NEXT, name);
+}
+
+static void resolve_all() {
+  // dlsym() may end up in a wrapper itself
+  static bool resolving = false;
+  if (resolving)
+    return;
+  resolving = true;
+
+  // the lookups themselves are not violations
+  bool reporting = rt_reporting;
+  rt_reporting = true;
+  resolve(&next_pthread_mutex_lock, "pthread_mutex_lock");
+  resolve(&next_pthread_cond_wait, "pthread_cond_wait");
+  resolve(&next_pthread_rwlock_rdlock, "pthread_rwlock_rdlock");
+  resolve(&next_pthread_rwlock_wrlock, "pthread_rwlock_wrlock");
+  resolve(&next_read, "read");
+  resolve(&next_write, "write");
+  resolve(&next_nanosleep, "nanosleep");
+  resolve(&next_usleep, "usleep");
+  resolve(&next_sched_yield, "sched_yield");
+  resolve(&next_select, "select");
+  resolve(&next_syscall, "syscall");
+  rt_reporting = reporting;
+  resolving = false;
+}
+
+// a wrapper called by another library's constructor before ours ran
+// resolves everything itself, there is no real-time scope that early
+#define NEXT(name) (next_##name ? next_##name : (resolve_all(), next_##name))
+
+// exit status when there were violations, RR_RT_EXIT_STATUS overrides it
+static int violation_exit_status = 1;
+
+__attribute__((constructor))
+static void rr_rt_init() {
+  resolve_all();
+
+  const char* reports = getenv("RR_RT_REPORTS");
+  if (reports)
+    max_reports = atoi(reports);
+  abort_on_violation = getenv("RR_RT_ABORT");
+  const char* status = getenv("RR_RT_EXIT_STATUS");
+  if (status)
+    violation_exit_status = atoi(status);
+
+  // the first backtrace() loads libgcc (and allocates), get that done now
+  void* frames[1];
+  backtrace(frames, 1);
+
+  fprintf(stderr, "[rtcheck] real-time checker loaded\n");
+}
+
+__attribute__((destructor))
+static void rr_rt_done() {
+  long count = violations;
+  fprintf(stderr, "[rtcheck] %ld violation(s)\n", count);
+
+  // fail the run (e.g. a headless test run) when anything was reported
+  if (count > 0 && violation_exit_status != 0) {
+    fflush(NULL);
+    _exit(violation_exit_status);
+  }
+}
+
+extern "C" {
+
+// the scope hooks the plugin calls (see RRRealtimeScope)
+
+void rr_rt_enter(const char* what) {
+  if (rt_depth++ == 0)
+    rt_what = what;
+}
+
+void rr_rt_leave() {
+  if (rt_depth > 0)
+    rt_depth--;
+}
+
+// allocations
+
+void* malloc(size_t size) {
+  report("malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  report("calloc");
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  report("realloc");
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  report("memalign");
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  report("aligned_alloc");
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  report("posix_memalign");
+  void* p = __libc_memalign(alignment, size);
+  if (!p)
+    return ENOMEM;
+  *ptr = p;
+  return 0;
+}
+
+void free(void* ptr) {
+  if (ptr)
+    report("free");
+  __libc_free(ptr);
+}
+
+// locks (std::mutex and the logger end up here)
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+  report("pthread_mutex_lock");
+  return NEXT(pthread_mutex_lock)(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+  report("pthread_cond_wait");
+  return NEXT(pthread_cond_wait)(cond, mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) {
+  report("pthread_rwlock_rdlock");
+  return NEXT(pthread_rwlock_rdlock)(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) {
+  report("pthread_rwlock_wrlock");
+  return NEXT(pthread_rwlock_wrlock)(lock);
+}
+
+// syscalls that block or do I/O. the clocks (clock_gettime,
+// gettimeofday) go through the vDSO and are not syscalls on Linux.
+
+ssize_t read(int fd, void* buf, size_t count) {
+  report("read");
+  return NEXT(read)(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count) {
+  report("write");
+  return NEXT(write)(fd, buf, count);
+}
+
+int nanosleep(const struct timespec* req, struct timespec* rem) {
+  report("nanosleep");
+  return NEXT(nanosleep)(req, rem);
+}
+
+int usleep(useconds_t usec) {
+  report("usleep");
+  return NEXT(usleep)(usec);
+}
+
+int sched_yield() {
+  report("sched_yield");
+  return NEXT(sched_yield)();
+}
+
+int select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* exceptfds, struct timeval* timeout) {
+  report("select");
+  return NEXT(select)(nfds, readfds, writefds, exceptfds, timeout);
+}
+
+long syscall(long number, ...) {
+  report("syscall");
+
+  // the syscall ABI takes up to 6 arguments
+  va_list args;
+  va_start(args, number);
+  long a[6];
+  for (int i = 0; i < 6; i++)
+    a[i] = va_arg(args, long);
+  va_end(args);
+  return NEXT(syscall)(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+}
@@ -4,6 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
+#include "rr_modulewidget.hpp"
 #include <dsp/digital.hpp>
 
 struct Thermae : RRModule {
@@ -42,17 +43,30 @@ struct Thermae : RRModule {
                   NUM_LIGHTS
   };
 
-  // periodic internal clock processing
-  dsp::ClockDivider disable_hold_mode_clk;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {MIX_PARAM,   MIX_INPUT,   14, 0, 127, RR_CURVE_LINEAR},
+    {LPF_PARAM,   LPF_INPUT,   15, 0, 127, RR_CURVE_LINEAR},
+    {REGEN_PARAM, REGEN_INPUT, 16, 0, 127, RR_CURVE_LINEAR},
+    {GLIDE_PARAM, GLIDE_INPUT, 17, 0, 127, RR_CURVE_LINEAR},
+    {INT1_PARAM,  INT1_INPUT,  18, 0, 127, RR_CURVE_LINEAR},
+    {INT2_PARAM,  INT2_INPUT,  19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  // periodic internal clock processing (timebase seconds)
+  double last_hold_mode_reset = 0.0;
   int disable_hold_mode_attempts = 0;
 
   // tap tempo LED colors
   int curr_tap_tempo_light_color = 1; // 1=red, 0=green
 
-  dsp::SchmittTrigger tap_tempo_trigger_high;
+  RRGateBank<1> gates;
 
   Thermae() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({TAP_TEMPO_INPUT_HIGH});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(MIX_PARAM, 0.f, 127.f, 0.f, "Mix (Wet/Dry)");
@@ -77,13 +91,28 @@ struct Thermae : RRModule {
 
     // tap tempo buttons
     configParam(TAP_TEMPO_PARAM, 0.f, 1.f, 0.f, "Tap Tempo");
+  }
 
-    // keep an internal clock to disable hold mode (~every 1s) for up
-    // to 5 times after it has been turned on.
-    disable_hold_mode_clk.setDivision(65536);
+  bool timers_idle() override {
+    // tap tempo repeats while held, the hold mode reset runs on a timer
+    return params[TAP_TEMPO_PARAM].getValue() == 0.f
+      && disable_hold_mode_attempts == 0
+      && RRModule::timers_idle();
   }
 
-  void process(const ProcessArgs& args) override {
+  void set_tap_tempo_light(float brightness) {
+    if (brightness >= 0) {
+      // flash the current color using the processed brightness value
+      lights[TAP_TEMPO_LIGHT + curr_tap_tempo_light_color].setBrightness(brightness);
+      // turn off the other color in case it is still on
+      lights[TAP_TEMPO_LIGHT + (!curr_tap_tempo_light_color)].setBrightness(0.f);
+    }
+  }
+
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -98,6 +127,12 @@ struct Thermae : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do, the tempo LED keeps blinking
+    if (is_idle()) {
+      set_tap_tempo_light(blink_tap_tempo());
+      return;
+    }
+
     // handle a clock message
     if (inputs[CLOCK_INPUT].isConnected()) {
       bool clock = inputs[CLOCK_INPUT].getVoltage() >= 1.f;
@@ -122,23 +157,14 @@ struct Thermae : RRModule {
       hold_mode = 127;
 
     // read the gate triggers
-    int tap_gate = 0;
-    if (inputs[TAP_TEMPO_INPUT_HIGH].isConnected()) {
-      if (tap_tempo_trigger_high.process(rescale(inputs[TAP_TEMPO_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, trigger a tap tempo
-        tap_gate = 1;
-      }
-    }
+    uint32_t triggered = gates.process(inputs);
+    // if the trigger goes high, trigger a tap tempo
+    int tap_gate = (triggered & (1 << TAP_TEMPO_INPUT_HIGH)) ? 1 : 0;
 
     // process any tap tempo requests
     int tap_tempo = (int) floor(params[TAP_TEMPO_PARAM].getValue());
     float tap_tempo_brightness = process_tap_tempo(tap_gate ? 1 : tap_tempo);
-    if (tap_tempo_brightness >= 0) {
-      // flash the current color using the processed brightness value
-      lights[TAP_TEMPO_LIGHT + curr_tap_tempo_light_color].setBrightness(tap_tempo_brightness);
-      // turn off the other color in case it is still on
-      lights[TAP_TEMPO_LIGHT + (!curr_tap_tempo_light_color)].setBrightness(0.f);
-    }
+    set_tap_tempo_light(tap_tempo_brightness);
 
     // bypass or enable the pedal
     int enable_pedal = (int) floor(params[BYPASS_PARAM].getValue());
@@ -153,7 +179,7 @@ struct Thermae : RRModule {
     }
 
     // enable or bypass the pedal
-    midi_out.sendCachedCC(bypass, 102);
+    midi_out.sendCachedCCNow(bypass, 102);
 
     // 3way switch values (1,2,3)
     int l_toggle = (int) floor(params[L_TOGGLE_PARAM].getValue());
@@ -161,87 +187,50 @@ struct Thermae : RRModule {
     int r_toggle = (int) floor(params[R_TOGGLE_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(l_toggle, 21);
-    midi_out.sendCachedCC(m_toggle, 22);
-    midi_out.sendCachedCC(r_toggle, 23);
+    midi_out.sendCachedCCNow(l_toggle, 21);
+    midi_out.sendCachedCCNow(m_toggle, 22);
+    midi_out.sendCachedCCNow(r_toggle, 23);
 
-    // periodically reset the CC message cache for hold mode if it is
+    // periodically (~every 1s) reset the CC message cache for hold mode if it is
     // not turned on by the user. This is so that it doesn't get stuck turned on.
     if (!hold_mode) {
-      if (disable_hold_mode_attempts > 0 && disable_hold_mode_clk.process()) {
+      if (disable_hold_mode_attempts > 0 && should_transition_to_state(1.0f, last_hold_mode_reset)) {
         disable_hold_mode_attempts--;
+        last_hold_mode_reset = curr_time;
         midi_out.resetCCCache(24);
       }
     } else {
       // hold mode is being requested, reset the hold mode attempts
       disable_hold_mode_attempts = 5;
+      last_hold_mode_reset = curr_time;
     }
 
     // enable/disable hold mode and/or slowdown mode
-    midi_out.sendCachedCC(hold_mode, 24);
-    midi_out.sendCachedCC(slowdown_mode, 25);
+    midi_out.sendCachedCCNow(hold_mode, 24);
+    midi_out.sendCachedCCNow(slowdown_mode, 25);
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int mix = (int) std::round(params[MIX_PARAM].getValue());
-    int lpf = (int) std::round(params[LPF_PARAM].getValue());
-    int regen = (int) std::round(params[REGEN_PARAM].getValue());
-    int glide = (int) std::round(params[GLIDE_PARAM].getValue());
-    int int1 = (int) std::round(params[INT1_PARAM].getValue());
-    int int2 = (int) std::round(params[INT2_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs, use the knob value as a ceiling
-    if (inputs[MIX_INPUT].isConnected()) {
-      int mix_cv = convertCVtoCC(inputs[MIX_INPUT].getVoltage());
-      mix = clamp(mix_cv, 0, mix);
-    }
-    if (inputs[LPF_INPUT].isConnected()) {
-      int lpf_cv = convertCVtoCC(inputs[LPF_INPUT].getVoltage());
-      lpf = clamp(lpf_cv, 0, lpf);
-    }
-    if (inputs[REGEN_INPUT].isConnected()) {
-      int regen_cv = convertCVtoCC(inputs[REGEN_INPUT].getVoltage());
-      regen = clamp(regen_cv, 0, regen);
-    }
-    if (inputs[GLIDE_INPUT].isConnected()) {
-      int glide_cv = convertCVtoCC(inputs[GLIDE_INPUT].getVoltage());
-      glide = clamp(glide_cv, 0, glide);
-    }
-    if (inputs[INT1_INPUT].isConnected()) {
-      int int1_cv = convertCVtoCC(inputs[INT1_INPUT].getVoltage());
-      int1 = clamp(int1_cv, 0, int1);
-    }
-    if (inputs[INT2_INPUT].isConnected()) {
-      int int2_cv = convertCVtoCC(inputs[INT2_INPUT].getVoltage());
-      int2 = clamp(int2_cv, 0, int2);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(mix, 14);
-    midi_out.sendCachedCC(lpf, 15);
-    midi_out.sendCachedCC(regen, 16);
-    midi_out.sendCachedCC(glide, 17);
-    midi_out.sendCachedCC(int1, 18);
-    midi_out.sendCachedCC(int2, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
 };
 
-struct ThermaeWidget : ModuleWidget {
+constexpr RRKnobCC Thermae::KNOBS[];
+
+struct ThermaeWidget : RRModuleWidget {
   ThermaeWidget(Thermae* module) {
     setModule(module);
 
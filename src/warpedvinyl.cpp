@@ -4,7 +4,7 @@
 #include "guicomponents.hpp"
 #include "rr_module.hpp"
 #include "rr_midiwidget.hpp"
-#include <sys/time.h>
+#include "rr_modulewidget.hpp"
 
 struct WarpedVinyl : RRModule {
   enum ParamIds {
@@ -38,10 +38,23 @@ struct WarpedVinyl : RRModule {
                   NUM_LIGHTS
   };
 
-  dsp::SchmittTrigger tap_tempo_trigger_high;
+  // knobs that map straight onto a CC, the cv uses the knob value as a ceiling
+  static constexpr RRKnobCC KNOBS[] = {
+    // param, input, cc, min, max, curve
+    {TONE_PARAM,  TONE_INPUT,  14, 0, 127, RR_CURVE_LINEAR},
+    {LAG_PARAM,   LAG_INPUT,   15, 0, 127, RR_CURVE_LINEAR},
+    {MIX_PARAM,   MIX_INPUT,   16, 0, 127, RR_CURVE_LINEAR},
+    {RPM_PARAM,   RPM_INPUT,   17, 0, 127, RR_CURVE_LINEAR},
+    {DEPTH_PARAM, DEPTH_INPUT, 18, 0, 127, RR_CURVE_LINEAR},
+    {WARP_PARAM,  WARP_INPUT,  19, 0, 127, RR_CURVE_LINEAR}
+  };
+
+  RRGateBank<1> gates;
 
   WarpedVinyl() {
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+    gates.config({TAP_TEMPO_INPUT_HIGH});
+    config_knobs(KNOBS);
 
     // main knob parameters
     configParam(TONE_PARAM, 0.f, 127.f, 64.f, "Tone");
@@ -62,7 +75,17 @@ struct WarpedVinyl : RRModule {
     configParam(TAP_TEMPO_PARAM, 0.f, 1.f, 0.f, "Tap Tempo");
   }
 
-  void process(const ProcessArgs& args) override {
+  void set_tap_tempo_light(float brightness) {
+    if (brightness >= 0) {
+      // flash the light using the processed brightness value
+      lights[TAP_TEMPO_LIGHT].setBrightness(brightness);
+    }
+  }
+
+  void process_pedal(const ProcessArgs& args) override {
+    // keep the timers moving
+    advance_timebase(args);
+
     // only proceed if midi is activated
     if (!midi_out.active()) {
       if (!disable_module()) {
@@ -76,6 +99,12 @@ struct WarpedVinyl : RRModule {
       enable_module();
     }
 
+    // skip the rest if there is nothing to do, the tempo LED keeps blinking
+    if (is_idle()) {
+      set_tap_tempo_light(blink_tap_tempo());
+      return;
+    }
+
     // handle a clock message
     if (inputs[CLOCK_INPUT].isConnected()) {
       bool clock = inputs[CLOCK_INPUT].getVoltage() >= 1.f;
@@ -86,21 +115,14 @@ struct WarpedVinyl : RRModule {
     }
 
     // read the gate triggers
-    int tap_gate = 0;
-    if (inputs[TAP_TEMPO_INPUT_HIGH].isConnected()) {
-      if (tap_tempo_trigger_high.process(rescale(inputs[TAP_TEMPO_INPUT_HIGH].getVoltage(), 0.1f, 2.f, 0.f, 1.f))) {
-        // if the trigger goes high, trigger a tap tempo
-        tap_gate = 1;
-      }
-    }
+    uint32_t triggered = gates.process(inputs);
+    // if the trigger goes high, trigger a tap tempo
+    int tap_gate = (triggered & (1 << TAP_TEMPO_INPUT_HIGH)) ? 1 : 0;
 
     // process any tap tempo requests
     int tap_tempo = (int) floor(params[TAP_TEMPO_PARAM].getValue());
     float tap_tempo_brightness = process_tap_tempo(tap_gate ? 1 : tap_tempo);
-    if (tap_tempo_brightness >= 0) {
-      // flash the current color using the processed brightness value
-      lights[TAP_TEMPO_LIGHT].setBrightness(tap_tempo_brightness);
-    }
+    set_tap_tempo_light(tap_tempo_brightness);
 
     // bypass or enable the pedal
     int enable_pedal = (int) floor(params[BYPASS_PARAM].getValue());
@@ -115,75 +137,36 @@ struct WarpedVinyl : RRModule {
     }
 
     // enable or bypass the pedal
-    midi_out.sendCachedCC(bypass, 102);
+    midi_out.sendCachedCCNow(bypass, 102);
 
     // left switch values (0,1,2,3,4,5)
     int note_division = (int) floor(params[NOTE_DIVISION_PARAM].getValue());
 
     // assign values from switches
-    midi_out.sendCachedCC(note_division, 21);
+    midi_out.sendCachedCCNow(note_division, 21);
 
     // apply rate limiting here so that we do not flood the
     // system with midi messages caused by the CV inputs.
-    if (should_rate_limit(0.005f, args.sampleTime))
+    if (should_rate_limit(control_clock.tick, args.sampleTime))
       return;
 
-    // knob values
-    int tone = (int) std::round(params[TONE_PARAM].getValue());
-    int lag = (int) std::round(params[LAG_PARAM].getValue());
-    int mix = (int) std::round(params[MIX_PARAM].getValue());
-    int rpm = (int) std::round(params[RPM_PARAM].getValue());
-    int depth = (int) std::round(params[DEPTH_PARAM].getValue());
-    int warp = (int) std::round(params[WARP_PARAM].getValue());
-    int expr = -1;
-
-    // read cv voltages and override values of knobs, use the knob value as a ceiling
-    if (inputs[TONE_INPUT].isConnected()) {
-      int tone_cv = convertCVtoCC(inputs[TONE_INPUT].getVoltage());
-      tone = clamp(tone_cv, 0, tone);
-    }
-    if (inputs[LAG_INPUT].isConnected()) {
-      int lag_cv = convertCVtoCC(inputs[LAG_INPUT].getVoltage());
-      lag = clamp(lag_cv, 0, lag);
-    }
-    if (inputs[MIX_INPUT].isConnected()) {
-      int mix_cv = convertCVtoCC(inputs[MIX_INPUT].getVoltage());
-      mix = clamp(mix_cv, 0, mix);
-    }
-    if (inputs[RPM_INPUT].isConnected()) {
-      int rpm_cv = convertCVtoCC(inputs[RPM_INPUT].getVoltage());
-      rpm = clamp(rpm_cv, 0, rpm);
-    }
-    if (inputs[DEPTH_INPUT].isConnected()) {
-      int depth_cv = convertCVtoCC(inputs[DEPTH_INPUT].getVoltage());
-      depth = clamp(depth_cv, 0, depth);
-    }
-    if (inputs[WARP_INPUT].isConnected()) {
-      int warp_cv = convertCVtoCC(inputs[WARP_INPUT].getVoltage());
-      warp = clamp(warp_cv, 0, warp);
-    }
-    if (inputs[EXPR_INPUT].isConnected()) {
-      int expr_cv = convertCVtoCC(inputs[EXPR_INPUT].getVoltage());
-      expr = clamp(expr_cv, 0, 127);
-    }
-
     // assign values from knobs (or cv)
-    midi_out.sendCachedCC(tone, 14);
-    midi_out.sendCachedCC(lag, 15);
-    midi_out.sendCachedCC(mix, 16);
-    midi_out.sendCachedCC(rpm, 17);
-    midi_out.sendCachedCC(depth, 18);
-    midi_out.sendCachedCC(warp, 19);
+    send_knob_ccs(KNOBS);
 
     // assign value for expression
-    if (expr > 0)
-      midi_out.sendCachedCC(expr, 100);
+    send_expression_cc(EXPR_INPUT);
+
+    // send everything that changed during this control block
+    midi_out.flushCachedCCs();
+    controls_done();
 
     return;
   }
 };
 
-struct WarpedVinylWidget : ModuleWidget {
+constexpr RRKnobCC WarpedVinyl::KNOBS[];
+
+struct WarpedVinylWidget : RRModuleWidget {
   WarpedVinylWidget(WarpedVinyl* module) {
     setModule(module);
 
@@ -0,0 +1,78 @@
+// headless benchmark of the real modules (src/*.cpp on the headless engine
+// in test/rack, see scenarios/rr_rig.hpp). every scenario runs on every
+// one of the nine pedals at 44.1, 96 and 192 kHz, on its own loopback
+// device. the cost is per sample of the engine's sample loop, the rates
+// are per second of simulated time and count what reached the device.
+//
+// the scaling run then puts N = 1 to 64 modules, the nine pedals in turn,
+// running the cv_lfo scenario on one shared device at the DIN rate. the
+// aggregator is run on the engine's thread and a simulated clock, so the
+// numbers are the scheduler's, not the driver's.
+
+#include "scenarios/rr_scenarios.hpp"
+#include <cstdio>
+#include <cstring>
+
+static const float SAMPLE_RATES[] = {44100.f, 96000.f, 192000.f};
+static const int BLOCK_SIZE = 256;
+static const float BYTE_RATE = 3125.f;
+
+// the scaling run
+static const char* SCALING_SCENARIO = "cv_lfo";
+static const float SCALING_SAMPLE_RATE = 44100.f;
+static const int SCALING_MAX_MODULES = 64;
+
+static void run_scaling(const RRScenario& scenario, int modules) {
+  RRRig rig(SCALING_SAMPLE_RATE, BLOCK_SIZE);
+  for (int m = 0; m < modules; m++)
+    rig.addModule(RRRig::findModel(RR_SCENARIO_MODULES[m % RR_NUM_SCENARIO_MODULES]), m % 16, BYTE_RATE);
+
+  rr_run_scenario(scenario, rig);
+
+  uint64_t queued = 0;
+  for (RRModule* module : rig.modules)
+    queued += module->midi_out.queuedMessages;
+  RRMidiDeviceStats stats = rig.getStats();
+
+  printf("%8d %12.1f %12.1f %12.1f %8llu %10.2f %10.2f %10.2f %12.1f\n", modules,
+    queued / scenario.duration, stats.sent / scenario.duration,
+    rig.wireBytes / scenario.duration, (unsigned long long) stats.lost,
+    stats.hold * 1e3, stats.avgQueueing * 1e3, stats.maxQueueing * 1e3,
+    rig.processTime / (rig.engine.frame * (double) modules) * 1e9);
+}
+
+int main() {
+  printf("%-12s %-12s %8s %12s %12s %12s\n", "module", "scenario", "rate", "ns/sample", "messages/s", "bytes/s");
+
+  const RRScenario* scaling = NULL;
+  for (int m = 0; m < RR_NUM_SCENARIO_MODULES; m++) {
+    plugin::Model* model = RRRig::findModel(RR_SCENARIO_MODULES[m]);
+
+    for (int s = 0; s < RR_NUM_SCENARIOS; s++) {
+      const RRScenario& scenario = RR_SCENARIOS[s];
+      if (!strcmp(scenario.name, SCALING_SCENARIO))
+        scaling = &scenario;
+
+      for (float sample_rate : SAMPLE_RATES) {
+        RRRig rig(sample_rate, BLOCK_SIZE);
+        rig.addModule(model, 0, BYTE_RATE);
+        rr_run_scenario(scenario, rig);
+
+        RRMidiDeviceStats stats = rig.getStats();
+        printf("%-12s %-12s %8.0f %12.1f %12.1f %12.1f\n", model->slug.c_str(), scenario.name, sample_rate,
+          rig.processTime / rig.engine.frame * 1e9,
+          stats.sent / scenario.duration, rig.wireBytes / scenario.duration);
+      }
+    }
+  }
+
+  // the latency is split in the hold (one engine block) and the time the
+  // messages spent queueing behind each other for the wire
+  printf("\n%s on one device, %.0f Hz, %d sample blocks, %.0f bytes/s\n",
+    SCALING_SCENARIO, SCALING_SAMPLE_RATE, BLOCK_SIZE, BYTE_RATE);
+  printf("%8s %12s %12s %12s %8s %10s %10s %10s %12s\n", "modules", "queued/s",
+    "sent/s", "bytes/s", "lost", "hold ms", "queue avg", "queue max", "ns/sample");
+  for (int modules = 1; modules <= SCALING_MAX_MODULES; modules *= 2)
+    run_scaling(*scaling, modules);
+  return 0;
+}
@@ -0,0 +1,29 @@
+#include "rr_test.hpp"
+
+const char* rr_test_name = NULL;
+int rr_test_failures = 0;
+
+static std::vector<RRTestCase*>& tests() {
+  static std::vector<RRTestCase*> tests;
+  return tests;
+}
+
+RRTestCase::RRTestCase(const char* name, void (*fn)()) : name(name), fn(fn) {
+  tests().push_back(this);
+}
+
+int main() {
+  int failed = 0;
+  for (RRTestCase* test : tests()) {
+    rr_test_name = test->name;
+    int failures = rr_test_failures;
+    test->fn();
+    bool ok = rr_test_failures == failures;
+    if (!ok)
+      failed++;
+    printf("%s %s\n", ok ? "ok  " : "FAIL", test->name);
+  }
+
+  printf("%d of %d tests failed\n", failed, (int) tests().size());
+  return failed ? 1 : 0;
+}
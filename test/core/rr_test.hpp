@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "core/rr_cc.hpp"
+
+// a minimal test harness for the core library, `make core-test` builds
+// and runs every RR_TEST of test/core.
+
+struct RRTestCase {
+  const char* name;
+  void (*fn)();
+
+  RRTestCase(const char* name, void (*fn)());
+};
+
+// the test that is running and the number of failed checks
+extern const char* rr_test_name;
+extern int rr_test_failures;
+
+#define RR_TEST(name) \
+  static void name(); \
+  static RRTestCase name##_case(#name, name); \
+  static void name()
+
+#define RR_CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, rr_test_name, #cond); \
+      rr_test_failures++; \
+    } \
+  } while (0)
+
+#define RR_CHECK_EQ(a, b) \
+  do { \
+    long long a_ = (long long) (a), b_ = (long long) (b); \
+    if (a_ != b_) { \
+      fprintf(stderr, "%s:%d: %s: %s == %s failed (%lld != %lld)\n", __FILE__, __LINE__, rr_test_name, #a, #b, a_, b_); \
+      rr_test_failures++; \
+    } \
+  } while (0)
+
+#define RR_CHECK_NEAR(a, b, eps) \
+  do { \
+    double a_ = (a), b_ = (b); \
+    if (std::fabs(a_ - b_) > (eps)) { \
+      fprintf(stderr, "%s:%d: %s: %s ~ %s failed (%g != %g)\n", __FILE__, __LINE__, rr_test_name, #a, #b, a_, b_); \
+      rr_test_failures++; \
+    } \
+  } while (0)
+
+// a message handed to the wire by RRTestCCCache
+struct RRTestMessage {
+  int status;
+  int data1;
+  int data2;
+  bool dummy;
+  int lsb;
+};
+
+// CC cache that records what it enqueues
+struct RRTestCCCache : RRCCCache {
+  std::vector<RRTestMessage> sent;
+
+  void enqueue(uint8_t status, uint8_t data1, uint8_t data2, uint8_t size, bool dummy, int lsb) override {
+    RRTestMessage msg = {status, data1, data2, dummy, lsb};
+    sent.push_back(msg);
+  }
+};
@@ -0,0 +1,121 @@
+#include "rr_test.hpp"
+#include "core/rr_blooper.hpp"
+
+// presses one button for a single sample
+static void press(RRBlooperTransport& transport, RRTestCCCache& cache, double now,
+                  bool RRBlooperTransport::Buttons::*button) {
+  RRBlooperTransport::Buttons buttons;
+  buttons.*button = true;
+  transport.process(&cache, buttons, now);
+}
+
+static void idle(RRBlooperTransport& transport, RRTestCCCache& cache, double now) {
+  transport.process(&cache, RRBlooperTransport::Buttons(), now);
+}
+
+// the last transport command (CC 11) that went out
+static int last_command(RRTestCCCache& cache) {
+  for (size_t i = cache.sent.size(); i-- > 0;) {
+    if (cache.sent[i].status == 0xb0 && cache.sent[i].data1 == 11)
+      return cache.sent[i].data2;
+  }
+  return -1;
+}
+
+RR_TEST(blooper_record_play_overdub_stop_erase) {
+  RRBlooperTransport transport;
+  RRTestCCCache cache;
+
+  press(transport, cache, 0.0, &RRBlooperTransport::Buttons::record);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::RECORDING);
+  RR_CHECK_EQ(last_command(cache), 1);
+
+  press(transport, cache, 1.0, &RRBlooperTransport::Buttons::play);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::PLAYING);
+  RR_CHECK_EQ(last_command(cache), 2);
+
+  press(transport, cache, 2.0, &RRBlooperTransport::Buttons::record);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::RECORDING);
+  RR_CHECK_EQ(last_command(cache), 3);
+
+  press(transport, cache, 3.0, &RRBlooperTransport::Buttons::stop);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::STOPPED);
+  RR_CHECK_EQ(last_command(cache), 4);
+
+  press(transport, cache, 4.0, &RRBlooperTransport::Buttons::erase);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::ERASING);
+  RR_CHECK_EQ(last_command(cache), 7);
+
+  // erasing ignores the buttons and times out
+  size_t sent = cache.sent.size();
+  press(transport, cache, 5.0, &RRBlooperTransport::Buttons::play);
+  RR_CHECK_EQ(cache.sent.size(), sent);
+  idle(transport, cache, 4.0 + RRBlooperTransport::ERASE_TIME + 0.01);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::UNKNOWN);
+}
+
+RR_TEST(blooper_commands_go_out_right_away) {
+  RRBlooperTransport transport;
+  RRTestCCCache cache;
+
+  // a knob is staged, the commands don't wait for the flush and
+  // are not coalesced
+  cache.sendCachedCC(64, 14);
+  press(transport, cache, 0.0, &RRBlooperTransport::Buttons::record);
+  RR_CHECK_EQ(last_command(cache), 1);
+  press(transport, cache, 0.0, &RRBlooperTransport::Buttons::stop);
+  RR_CHECK_EQ(last_command(cache), 4);
+  for (size_t i = 0; i < cache.sent.size(); i++)
+    RR_CHECK(cache.sent[i].data1 != 14);
+}
+
+RR_TEST(blooper_one_shot_record_times_out_to_play) {
+  RRBlooperTransport transport;
+  RRTestCCCache cache;
+
+  RRBlooperTransport::Buttons buttons;
+  buttons.record = true;
+  buttons.one_shot = true;
+  transport.process(&cache, buttons, 0.0);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::ONE_SHOT);
+  RR_CHECK_EQ(cache.sent.back().data1, 9);
+  RR_CHECK_EQ(cache.sent.back().data2, 1);
+
+  buttons = RRBlooperTransport::Buttons();
+  buttons.one_shot = true;
+  transport.process(&cache, buttons, RRBlooperTransport::ONE_SHOT_TIME + 0.01);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::PLAYING);
+  // one shot record is switched off on the pedal
+  RR_CHECK_EQ(cache.sent.back().data1, 9);
+  RR_CHECK_EQ(cache.sent.back().data2, 0);
+}
+
+RR_TEST(blooper_loop_select_stops_and_loads) {
+  RRBlooperTransport transport;
+  RRTestCCCache cache;
+
+  press(transport, cache, 0.0, &RRBlooperTransport::Buttons::play);
+
+  // the first loop change goes to loop 0
+  RRBlooperTransport::Buttons buttons;
+  buttons.loop_select = 1;
+  transport.process(&cache, buttons, 2.0);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::LOOP_CHANGE);
+  RR_CHECK_EQ(cache.sent[cache.sent.size() - 2].data2, 4);
+  RR_CHECK_EQ(cache.sent.back().status, 0xc0);
+  RR_CHECK_EQ(cache.sent.back().data1, 0);
+
+  // the buttons are ignored while the loop loads
+  size_t sent = cache.sent.size();
+  transport.process(&cache, buttons, 3.0);
+  press(transport, cache, 3.0, &RRBlooperTransport::Buttons::play);
+  RR_CHECK_EQ(cache.sent.size(), sent);
+
+  idle(transport, cache, 2.0 + RRBlooperTransport::LOOP_CHANGE_TIME + 0.01);
+  RR_CHECK_EQ(transport.state, RRBlooperTransport::STOPPED);
+
+  // then the loops wrap around
+  buttons.loop_select = -1;
+  transport.process(&cache, buttons, 10.0);
+  RR_CHECK_EQ(cache.currProgram, RRBlooperTransport::NUM_LOOPS - 1);
+}
@@ -0,0 +1,152 @@
+#include "rr_test.hpp"
+
+RR_TEST(cc_cache_coalesces_staged_values) {
+  RRTestCCCache cache;
+  RR_CHECK(cache.sendCachedCC(10, 14));
+  RR_CHECK(cache.sendCachedCC(20, 15));
+  RR_CHECK(cache.sendCachedCC(30, 14));
+  RR_CHECK_EQ(cache.sent.size(), 0);
+
+  // last value wins, in the order the CCs were first staged
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 2);
+  RR_CHECK_EQ(cache.sent[0].data1, 14);
+  RR_CHECK_EQ(cache.sent[0].data2, 30);
+  RR_CHECK(cache.sent[0].dummy);
+  RR_CHECK_EQ(cache.sent[1].data1, 15);
+  RR_CHECK_EQ(cache.sent[1].data2, 20);
+}
+
+RR_TEST(cc_cache_skips_values_on_the_wire) {
+  RRTestCCCache cache;
+  cache.sendCachedCC(10, 14);
+  cache.flushCachedCCs();
+
+  // the same value again, and a value that returned before the flush
+  RR_CHECK(!cache.sendCachedCC(10, 14));
+  RR_CHECK(cache.sendCachedCCNoDummy(11, 14));
+  cache.sendCachedCCNoDummy(10, 14);
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 1);
+
+  // a reset drops the values, they go out again
+  cache.resetCache();
+  cache.sendCachedCC(10, 14);
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 2);
+}
+
+RR_TEST(cc_cache_sends_now_and_drops_the_staged_value) {
+  RRTestCCCache cache;
+  cache.sendCachedCC(3, 11);
+  RR_CHECK(cache.sendCachedCCNow(4, 11));
+  RR_CHECK_EQ(cache.sent.size(), 1);
+  RR_CHECK_EQ(cache.sent[0].data2, 4);
+
+  // the staged value is gone, restaging lists the CC only once
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 1);
+  for (int i = 0; i < 200; i++) {
+    cache.sendCachedCC(i & 1, 11);
+    cache.sendCachedCCNow(2, 11);
+  }
+  RR_CHECK(cache.numPendingCCs <= 1);
+}
+
+RR_TEST(cc_cache_sends_14_bit_msb_and_lsb) {
+  RRTestCCCache cache;
+  cache.highResCCs = true;
+
+  cache.sendCachedCC14((64 << 7) | 5, 14);
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 1);
+  RR_CHECK_EQ(cache.sent[0].data1, 14);
+  RR_CHECK_EQ(cache.sent[0].data2, 64);
+  RR_CHECK_EQ(cache.sent[0].lsb, 5);
+
+  // only the LSB changed, it goes out on CC n+32
+  cache.sendCachedCC14((64 << 7) | 9, 14);
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 2);
+  RR_CHECK_EQ(cache.sent[1].data1, 46);
+  RR_CHECK_EQ(cache.sent[1].data2, 9);
+
+  // a new MSB with LSB 0 doesn't need the LSB
+  cache.sendCachedCC14(65 << 7, 14);
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 3);
+  RR_CHECK_EQ(cache.sent[2].data2, 65);
+  RR_CHECK_EQ(cache.sent[2].lsb, -1);
+}
+
+RR_TEST(cc_cache_falls_back_to_7_bit) {
+  RRTestCCCache cache;
+  cache.highResCCs = true;
+
+  // CC 46 (14 + 32) is used as a plain CC, 14 can't be 14-bit
+  cache.sendCachedCC(1, 46);
+  cache.sendCachedCC14(16383, 14);
+  cache.flushCachedCCs();
+  RR_CHECK_EQ(cache.sent.size(), 2);
+  RR_CHECK_EQ(cache.sent[1].data1, 14);
+  RR_CHECK_EQ(cache.sent[1].data2, 127);
+  RR_CHECK_EQ(cache.sent[1].lsb, -1);
+}
+
+RR_TEST(cc_cache_flushes_before_a_program_change) {
+  RRTestCCCache cache;
+  cache.sendCachedCC(10, 14);
+  RR_CHECK(cache.setProgram(3));
+  RR_CHECK(!cache.setProgram(3));
+  RR_CHECK_EQ(cache.sent.size(), 2);
+  RR_CHECK_EQ(cache.sent[0].status, 0xb0);
+  RR_CHECK_EQ(cache.sent[1].status, 0xc0);
+  RR_CHECK_EQ(cache.sent[1].data1, 3);
+
+  // the programs wrap around
+  cache.setProgram(15);
+  cache.incrementProgram(1, 16);
+  RR_CHECK_EQ(cache.currProgram, 0);
+  cache.decrementProgram(1, 16);
+  RR_CHECK_EQ(cache.currProgram, 15);
+}
+
+RR_TEST(cc_thinner_holds_back_predictable_values) {
+  RRCCThinner thinner;
+  double t = 0.0;
+
+  // a steady ramp, two points are needed to extrapolate
+  RR_CHECK(thinner.should_send(t, 0.f, 1.f, false));
+  RR_CHECK(thinner.should_send(t += 0.005, 1.f, 1.f, false));
+  int sent = 0;
+  for (int i = 2; i < 18; i++)
+    sent += thinner.should_send(t += 0.005, (float) i, 1.f, false);
+  RR_CHECK(sent < 4);
+  RR_CHECK(thinner.pending);
+
+  // once the control rests the last value goes out
+  bool sent_rest = false;
+  for (int i = 0; i < 20; i++)
+    sent_rest |= thinner.should_send(t += 0.005, 17.f, 1.f, false);
+  RR_CHECK(sent_rest);
+  RR_CHECK(!thinner.pending);
+  RR_CHECK_EQ(thinner.sent_value[1], 17);
+}
+
+RR_TEST(cc_thinner_sends_jumps_and_forced_values) {
+  RRCCThinner thinner;
+  thinner.should_send(0.0, 0.f, 1.f, false);
+  thinner.should_send(0.005, 1.f, 1.f, false);
+
+  // off the extrapolated line
+  RR_CHECK(thinner.should_send(0.010, 40.f, 1.f, false));
+  // forced, e.g. after the cache was dropped
+  RR_CHECK(thinner.should_send(0.015, 40.f, 1.f, true));
+}
+
+RR_TEST(hysteresis_holds_small_moves) {
+  RR_CHECK_EQ(rr_hysteresis(10.5f, 10.f, 1.f, 0.f, 127.f), 10);
+  RR_CHECK_EQ(rr_hysteresis(11.f, 10.f, 1.f, 0.f, 127.f), 11);
+  // the ends of the range always get through
+  RR_CHECK_EQ(rr_hysteresis(127.f, 126.5f, 1.f, 0.f, 127.f), 127);
+}
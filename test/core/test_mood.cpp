@@ -0,0 +1,49 @@
+#include "rr_test.hpp"
+#include "core/rr_mood.hpp"
+
+RR_TEST(mood_loop_program_change_bypasses_the_loop) {
+  RRMoodSwitches switches;
+  RRTestCCCache cache;
+
+  // both channels on, the loop program goes out and the pedal
+  // bypasses the loop for it
+  switches.blood = true;
+  switches.loop = true;
+  RR_CHECK_EQ(switches.process(&cache, 2, 2, 2), 85);
+  RR_CHECK(!switches.loop);
+
+  switches.loop = true;
+  RR_CHECK_EQ(switches.process(&cache, 2, 2, 2), 127);
+  RR_CHECK(switches.loop);
+
+  // a new loop program, loop bypassed again
+  RR_CHECK_EQ(switches.process(&cache, 2, 2, 3), 85);
+  RR_CHECK(!switches.loop);
+  RR_CHECK_EQ(cache.getCachedCCValue(23), 3);
+  RR_CHECK_EQ(cache.getCachedCCValue(103), 85);
+
+  // the loop alone
+  switches.blood = false;
+  switches.loop = true;
+  RR_CHECK_EQ(switches.process(&cache, 2, 2, 3), 45);
+}
+
+RR_TEST(mood_switches_go_out_without_waiting_for_the_flush) {
+  RRMoodSwitches switches;
+  RRTestCCCache cache;
+
+  switches.blood = true;
+  switches.loop = false;
+  switches.process(&cache, 1, 2, 3);
+  RR_CHECK_EQ(cache.sent.size(), 4u);
+  RR_CHECK_EQ(cache.sent[2].data1, 23);
+  RR_CHECK_EQ(cache.sent[3].data1, 103);
+  RR_CHECK_EQ(cache.sent[3].data2, 85);
+
+  // the same program again keeps the loop on and sends nothing new
+  switches.loop = true;
+  switches.process(&cache, 1, 2, 3);
+  RR_CHECK_EQ(switches.process(&cache, 1, 2, 3), 127);
+  RR_CHECK(switches.loop);
+  RR_CHECK_EQ(cache.sent.size(), 5u);
+}
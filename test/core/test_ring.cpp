@@ -0,0 +1,54 @@
+#include "rr_test.hpp"
+#include "core/rr_ring.hpp"
+#include <thread>
+
+RR_TEST(mpsc_ring_takes_every_message_of_every_sender_in_order) {
+  static RRMpscRing<int, 256> ring;
+  const int SENDERS = 4;
+  const int MESSAGES = 100000;
+
+  std::vector<std::thread> senders;
+  for (int s = 0; s < SENDERS; s++) {
+    senders.push_back(std::thread([s, MESSAGES]() {
+      for (int i = 0; i < MESSAGES; i++) {
+        // full, wait for the consumer
+        while (!ring.push(s * MESSAGES + i))
+          std::this_thread::yield();
+      }
+    }));
+  }
+
+  // every sender's messages arrive once, in the order they were sent
+  int next[SENDERS] = {0};
+  int received = 0;
+  bool ordered = true;
+  while (received < SENDERS * MESSAGES) {
+    int value;
+    if (!ring.shift(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    int s = value / MESSAGES;
+    ordered = ordered && value % MESSAGES == next[s];
+    next[s]++;
+    received++;
+  }
+  for (std::thread& sender : senders)
+    sender.join();
+
+  RR_CHECK(ordered);
+  int value = -1;
+  RR_CHECK(!ring.shift(&value));
+}
+
+RR_TEST(mpsc_ring_refuses_a_message_when_full) {
+  RRMpscRing<int, 4> ring;
+  for (int i = 0; i < 4; i++)
+    RR_CHECK(ring.push(i));
+  RR_CHECK(!ring.push(4));
+
+  int value = -1;
+  RR_CHECK(ring.shift(&value));
+  RR_CHECK_EQ(value, 0);
+  RR_CHECK(ring.push(4));
+}
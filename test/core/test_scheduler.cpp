@@ -0,0 +1,190 @@
+#include "rr_test.hpp"
+#include "core/rr_scheduler.hpp"
+
+// a device that remembers what went on the wire and when
+struct RRTestDevice : RRMidiScheduler {
+  struct Sent {
+    int status;
+    int data1;
+    int data2;
+    double time;
+  };
+  std::vector<Sent> sent;
+
+  void send(const uint8_t* bytes, int size, int64_t frame) override {
+    sent.push_back({bytes[0], size > 1 ? bytes[1] : -1, size > 2 ? bytes[2] : -1, now});
+  }
+};
+
+static RRMidiMessage cc_message(int64_t frame, int cc, int value, bool priority) {
+  RRMidiMessage msg;
+  msg.frame = frame;
+  msg.bytes[0] = 0xb0;
+  msg.bytes[1] = cc;
+  msg.bytes[2] = value;
+  msg.size = 3;
+  msg.dummy = false;
+  msg.priority = priority;
+  msg.lsb = -1;
+  msg.slot = cc;
+  msg.generation = 0;
+  return msg;
+}
+
+RR_TEST(scheduler_reports_hold_and_queueing_apart) {
+  RRTestDevice device;
+  RRMidiQueue queue;
+  device.addQueue(&queue);
+  // 1kHz frames, held for 10ms, one CC per 10ms on the wire
+  device.setTiming(0, 0.0, 0.001, 0.01);
+  device.setRate(300.f, 0.0);
+  device.tokens = 0;
+
+  // two CCs on frame 0, the second one has to wait for the wire
+  queue.push(cc_message(0, 14, 1, false));
+  queue.push(cc_message(0, 15, 1, false));
+
+  // nothing goes out before the hold is over
+  double wakeup = device.poll(0.0, 0.1);
+  RR_CHECK(device.sent.empty());
+  RR_CHECK_NEAR(wakeup, 0.01, 1e-9);
+
+  device.poll(0.01, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 1);
+  device.poll(0.015, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 1);
+  device.poll(0.02, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 2);
+
+  RRMidiDeviceStats stats = device.getStats();
+  RR_CHECK_EQ(stats.sent, 2);
+  RR_CHECK_NEAR(stats.hold, 0.01, 1e-9);
+  RR_CHECK_NEAR(stats.avgQueueing, 0.005, 1e-9);
+  RR_CHECK_NEAR(stats.maxQueueing, 0.01, 1e-9);
+}
+
+RR_TEST(scheduler_breaks_the_running_status_after_every_dummy_by_default) {
+  RRTestDevice device;
+  RRMidiQueue queue;
+  device.addQueue(&queue);
+  device.setTiming(0, 0.0, 0.001, 0.01);
+
+  // patches from before the breaker modes keep their wire output
+  RRMidiMessage msg = cc_message(0, 14, 1, false);
+  msg.dummy = true;
+  queue.push(msg);
+  device.poll(0.01, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 2);
+
+  // the smart mode holds the dummy back until the status repeats
+  device.breakerMode = RRMidiScheduler::BREAKER_SMART;
+  msg = cc_message(10, 15, 1, false);
+  msg.dummy = true;
+  queue.push(msg);
+  device.poll(0.02, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 3);
+}
+
+RR_TEST(scheduler_sends_the_cc_flushed_before_a_program_change_first) {
+  RRTestDevice device;
+  RRMidiQueue queue;
+  device.addQueue(&queue);
+  device.setTiming(0, 0.0, 0.001, 0.0);
+
+  queue.push(cc_message(0, 14, 1, false));
+  RRMidiMessage program = cc_message(1, 3, 0, true);
+  program.bytes[0] = 0xc0;
+  program.size = 2;
+  queue.push(program);
+
+  device.poll(1.0, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 2);
+  RR_CHECK_EQ(device.sent[0].status, 0xb0);
+  RR_CHECK_EQ(device.sent[1].status, 0xc0);
+}
+
+// the 14-bit value a pedal ends up with on CC 14, a new MSB clears the LSB
+static int pedal_value_14(const RRTestDevice& device) {
+  int msb = 0, lsb = 0;
+  for (const RRTestDevice::Sent& sent : device.sent) {
+    if (sent.status != 0xb0)
+      continue;
+    if (sent.data1 == 14) {
+      msb = sent.data2;
+      lsb = 0;
+    } else if (sent.data1 == 46) {
+      lsb = sent.data2;
+    }
+  }
+  return (msb << 7) | lsb;
+}
+
+RR_TEST(scheduler_keeps_a_stale_lsb_behind_a_newer_msb) {
+  RRTestDevice device;
+  RRMidiQueue queue;
+  device.addQueue(&queue);
+  device.setTiming(0, 0.0, 0.001, 0.0);
+
+  // the wire is blocked while the knob moves
+  device.setRate(300.f, 0.0);
+  device.tokens = 0;
+
+  RRMidiMessage msb = cc_message(0, 14, 12, false);
+  msb.lsb = 3;
+  queue.push(msb);
+  RRMidiMessage lsb = cc_message(1, 46, 9, false);
+  lsb.slot = 14;
+  queue.push(lsb);
+  // the LSB went back to 0, only the MSB is sent
+  queue.push(cc_message(2, 14, 13, false));
+  device.poll(0.0, 0.1);
+  RR_CHECK(device.sent.empty());
+
+  // the wire opens up
+  for (double now = 0.01; now < 1.0; now += 0.01)
+    device.poll(now, 0.01);
+  RR_CHECK_EQ(device.sent.size(), 1);
+  RR_CHECK_EQ(pedal_value_14(device), 13 << 7);
+}
+
+RR_TEST(scheduler_merges_an_lsb_update_into_the_waiting_msb) {
+  RRTestDevice device;
+  RRMidiQueue queue;
+  device.addQueue(&queue);
+  device.setTiming(0, 0.0, 0.001, 0.0);
+  device.setRate(300.f, 0.0);
+  device.tokens = 0;
+
+  queue.push(cc_message(0, 14, 12, false));
+  RRMidiMessage lsb = cc_message(1, 46, 9, false);
+  lsb.slot = 14;
+  queue.push(lsb);
+  device.poll(0.0, 0.1);
+
+  for (double now = 0.01; now < 1.0; now += 0.01)
+    device.poll(now, 0.01);
+  RR_CHECK_EQ(device.sent.size(), 2);
+  RR_CHECK_EQ(pedal_value_14(device), (12 << 7) | 9);
+}
+
+RR_TEST(scheduler_drops_messages_queued_for_the_previous_device) {
+  RRTestDevice device;
+  RRMidiQueue queue;
+  device.setTiming(0, 0.0, 0.001, 0.0);
+
+  // the output moved to this device while the audio thread was still
+  // queueing for the old one
+  queue.push(cc_message(0, 14, 1, true));
+  queue.generation++;
+  device.addQueue(&queue);
+  device.poll(0.0, 0.1);
+  RR_CHECK(device.sent.empty());
+
+  // it caught up with the switch
+  RRMidiMessage msg = cc_message(1, 14, 2, true);
+  msg.generation = queue.generation;
+  queue.push(msg);
+  device.poll(0.01, 0.1);
+  RR_CHECK_EQ(device.sent.size(), 1);
+  RR_CHECK_EQ(device.sent[0].data2, 2);
+}
@@ -0,0 +1,132 @@
+#include "rr_test.hpp"
+#include "core/rr_timing.hpp"
+#include "core/rr_link.hpp"
+
+RR_TEST(rate_limiter_spreads_the_blocks) {
+  RRRateLimiter limiter;
+  float sample_time = 1.f / 48000;
+
+  // a 5ms period at 48kHz, one block every 240 samples
+  int blocks = 0;
+  for (int i = 0; i < 48000; i++)
+    blocks += !limiter.process(0.005f, sample_time);
+  RR_CHECK(blocks >= 199 && blocks <= 201);
+
+  // faster than the sample rate, never skip
+  for (int i = 0; i < 100; i++)
+    RR_CHECK(!limiter.process(sample_time / 2, sample_time));
+}
+
+RR_TEST(tap_tempo_blinks_at_the_tapped_rate) {
+  RRTapTempo tap;
+  bool tapped;
+
+  // the first tap goes out, holding the button doesn't repeat it
+  tap.process(true, 1.0, &tapped);
+  RR_CHECK(tapped);
+  tap.process(true, 1.05, &tapped);
+  RR_CHECK(!tapped);
+  RR_CHECK(!tap.blinking);
+
+  // released long enough, the second tap starts the blinking
+  tap.process(true, 1.2, &tapped);
+  tap.process(true, 1.5, &tapped);
+  RR_CHECK(tapped);
+  RR_CHECK(tap.blinking);
+  RR_CHECK_NEAR(tap.rate, 0.25, 1e-9);
+
+  // the LED turns on half an interval later
+  RR_CHECK(tap.process(false, 1.6, &tapped) < 0.f);
+  RR_CHECK_EQ(tap.process(false, 1.76, &tapped), 1);
+
+  // the idle path keeps it blinking without looking at the button
+  RR_CHECK(tap.blink(1.9) < 0.f);
+  RR_CHECK_EQ(tap.blink(2.02), 0);
+  RR_CHECK_EQ(tap.blink(2.27), 1);
+}
+
+RR_TEST(led_flasher_blinks_off) {
+  RRLedFlasher flasher;
+  RR_CHECK_EQ(flasher.process(0.5f, 1.0), 0);
+  RR_CHECK_EQ(flasher.process(0.5f, 1.05), 0);
+  RR_CHECK_EQ(flasher.process(0.5f, 1.2), 1);
+  RR_CHECK_EQ(flasher.process(0.5f, 1.6), 0);
+}
+
+RR_TEST(din_link_serializes_at_wire_speed) {
+  RRDinLink link;
+  double delay;
+
+  // a CC takes 3 bytes, the next one waits behind it
+  RR_CHECK(link.transmit(0.0, 3, &delay));
+  RR_CHECK_NEAR(delay, 3 * RRDinLink::BYTE_TIME, 1e-12);
+  RR_CHECK(link.transmit(0.0, 3, &delay));
+  RR_CHECK_NEAR(delay, 6 * RRDinLink::BYTE_TIME, 1e-12);
+  RR_CHECK_EQ(link.backlog(0.0), 6);
+  RR_CHECK_EQ(link.backlog(1.0), 0);
+
+  RR_CHECK_EQ(link.messages, 2);
+  RR_CHECK_EQ(link.bytes, 6);
+  RR_CHECK_NEAR(link.avg_delay(), 4.5 * RRDinLink::BYTE_TIME, 1e-12);
+}
+
+RR_TEST(din_link_drops_what_doesnt_fit) {
+  RRDinLink link;
+  link.buffer_size = 16;
+  double delay;
+
+  int accepted = 0;
+  for (int i = 0; i < 10; i++)
+    accepted += link.transmit(0.0, 3, &delay);
+  RR_CHECK_EQ(accepted, 5);
+  RR_CHECK_EQ(link.drops, 5);
+
+  // once the wire caught up there is room again
+  RR_CHECK(link.transmit(1.0, 3, &delay));
+  link.reset_stats();
+  RR_CHECK_EQ(link.messages, 0);
+}
+
+RR_TEST(control_clock_ticks_at_the_fastest_period) {
+  RRControlClock clock;
+  clock.set_period(0.005f);
+  clock.set_cc_period(14, 0.002f);
+  RR_CHECK_NEAR(clock.tick, 0.002f, 1e-9);
+  clock.set_load_factor(4);
+  RR_CHECK_NEAR(clock.tick, 0.008f, 1e-9);
+  RR_CHECK_NEAR(clock.get_cc_period(15), 0.02f, 1e-9);
+}
+
+RR_TEST(control_clock_sends_a_slow_knob_that_stopped_between_due_ticks) {
+  RRControlClock clock;
+  clock.set_period(0.005f);
+  clock.set_cc_period(14, 0.05f);
+  RRTestCCCache cache;
+
+  // a module's control blocks: they only run while something changed or
+  // a CC is still waiting for its period
+  bool pending = true;
+  float last_knob = -1.f;
+  for (int i = 0; i < 100; i++) {
+    double now = i * 0.005;
+
+    // the knob moves until 120ms, between the due ticks at 100ms and 150ms
+    float knob = (now < 0.12) ? std::floor(now * 100.f) : 12.f;
+    if (knob != last_knob) {
+      last_knob = knob;
+      pending = true;
+    }
+    if (!pending)
+      continue;
+
+    if (clock.cc_due(14, now))
+      cache.sendCachedCC((int) knob, 14);
+    cache.flushCachedCCs();
+    pending = clock.waiting();
+  }
+
+  // the final value made it out and nothing is left waiting
+  RR_CHECK_EQ(cache.getCachedCCValue(14), 12);
+  RR_CHECK(!clock.waiting());
+  RR_CHECK(cache.sent.size() <= 4);
+}
@@ -0,0 +1,80 @@
+// deterministic scenario drivers: every golden scenario (test/scenarios)
+// runs on each of the nine real modules, through its MIDI output and the
+// aggregator of a loopback device at the DIN rate (see rr_rig.hpp). the
+// byte stream that reaches the device is compared against its golden file
+// in test/golden/<module>/<scenario>.txt, the bytes and the frames have to
+// match exactly.
+//
+//   rrgolden <dir>            compares, reports every file that differs
+//   rrgolden --update <dir>   writes the golden files
+
+#include "scenarios/rr_scenarios.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+static const float GOLDEN_SAMPLE_RATE = 48000.f;
+static const int GOLDEN_BLOCK_SIZE = 256;
+static const float GOLDEN_BYTE_RATE = 3125.f;
+
+static void record(plugin::Model* model, const RRScenario& scenario, RRByteStream* stream) {
+  stream->clear();
+  stream->sampleRate = GOLDEN_SAMPLE_RATE;
+
+  RRRig rig(GOLDEN_SAMPLE_RATE, GOLDEN_BLOCK_SIZE);
+  rig.addModule(model, 0, GOLDEN_BYTE_RATE);
+  rig.recording = stream;
+  rr_run_scenario(scenario, rig);
+}
+
+int main(int argc, char** argv) {
+  bool update = argc == 3 && !strcmp(argv[1], "--update");
+  if (argc != 2 && !update) {
+    fprintf(stderr, "usage: %s [--update] <golden dir>\n", argv[0]);
+    return 2;
+  }
+  std::string dir = argv[argc - 1];
+
+  int failed = 0;
+  int files = 0;
+  for (int m = 0; m < RR_NUM_SCENARIO_MODULES; m++) {
+    plugin::Model* model = RRRig::findModel(RR_SCENARIO_MODULES[m]);
+    std::string module_dir = dir + "/" + model->slug;
+    if (update)
+      mkdir(module_dir.c_str(), 0755);
+
+    for (int s = 0; s < RR_NUM_SCENARIOS; s++) {
+      const RRScenario& scenario = RR_SCENARIOS[s];
+      if (!scenario.golden)
+        continue;
+      std::string name = model->slug + "/" + scenario.name;
+      std::string path = dir + "/" + name + ".txt";
+      files++;
+
+      RRByteStream recorded;
+      record(model, scenario, &recorded);
+
+      if (update) {
+        bool saved = recorded.save(path);
+        printf("%s %s (%d messages)\n", saved ? "saved" : "FAIL ", path.c_str(), (int) recorded.events.size());
+        failed += !saved;
+        continue;
+      }
+
+      RRByteStream golden;
+      std::string report;
+      bool ok = golden.load(path);
+      if (!ok)
+        report = "no golden file";
+      else
+        ok = recorded.compare(golden, 0.0, &report);
+      printf("%s %s: %s\n", ok ? "ok  " : "FAIL", name.c_str(), report.c_str());
+      failed += !ok;
+    }
+  }
+
+  if (!update)
+    printf("%d of %d scenarios differ\n", failed, files);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ui.hpp"
+
+namespace rack {
+namespace app {
+
+struct LedDisplay : widget::OpaqueWidget {};
+struct LedDisplaySeparator : widget::Widget {};
+
+struct LedDisplayChoice : widget::OpaqueWidget {
+  std::string text;
+  std::string fontPath;
+  math::Vec textOffset;
+  NVGcolor color;
+  NVGcolor bgColor;
+};
+
+struct LedDisplayTextField : widget::OpaqueWidget {
+  std::string text;
+};
+
+}
+using namespace app;
+}
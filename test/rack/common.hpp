@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// logging goes nowhere, the bench and the goldens print their own output
+#define DEBUG(format, ...) ::rack::logger_log(format, ##__VA_ARGS__)
+#define INFO(format, ...) ::rack::logger_log(format, ##__VA_ARGS__)
+#define WARN(format, ...) ::rack::logger_log(format, ##__VA_ARGS__)
+
+#define ENUMS(name, count) name, name ## _LAST = name + (count) - 1
+#define CHECKMARK_STRING "✔"
+#define CHECKMARK(_cond) ((_cond) ? CHECKMARK_STRING : "")
+#define RIGHT_ARROW "▸"
+#define PORT_MAX_CHANNELS 16
+#define RACK_GRID_WIDTH 15
+#define RACK_GRID_HEIGHT 380
+
+namespace rack {
+
+inline void logger_log(const char* format, ...) {}
+
+namespace string {
+
+inline std::string f(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  char buffer[1024];
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  return buffer;
+}
+
+}
+
+struct Context;
+Context* contextGet();
+void contextSet(Context* context);
+
+namespace system {
+
+// the simulated clock of the rig (see rack::headless::setTime())
+double getTime();
+
+inline void setThreadName(const std::string& name) {}
+
+inline std::string join(const std::string& a, const std::string& b) {
+  return a + "/" + b;
+}
+
+inline bool createDirectories(const std::string& path) {
+  return false;
+}
+
+inline bool exists(const std::string& path) {
+  return false;
+}
+
+inline std::string getDirectory(const std::string& path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? "" : path.substr(0, slash);
+}
+
+}
+
+namespace plugin {
+struct Plugin;
+struct Model;
+}
+using plugin::Plugin;
+using plugin::Model;
+
+namespace asset {
+
+inline std::string plugin(plugin::Plugin* p, std::string filename) {
+  return filename;
+}
+
+inline std::string system(std::string filename) {
+  return filename;
+}
+
+inline std::string user(std::string filename) {
+  return filename;
+}
+
+}
+
+// hooks of the headless engine that the real SDK doesn't have
+namespace headless {
+
+void setTime(double time);
+
+}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ui.hpp"
+#include "engine.hpp"
+#include "app/LedDisplay.hpp"
+
+namespace rack {
+namespace app {
+
+struct ModuleWidget : widget::OpaqueWidget {
+  engine::Module* module = NULL;
+
+  void setModule(engine::Module* module) {
+    this->module = module;
+  }
+  engine::Module* getModule() {
+    return module;
+  }
+  template <class T>
+  T* getModule() {
+    return dynamic_cast<T*>(module);
+  }
+
+  void setPanel(std::shared_ptr<window::Svg> svg) {}
+  void addParam(widget::Widget* param) {
+    addChild(param);
+  }
+  void addInput(widget::Widget* input) {
+    addChild(input);
+  }
+  void addOutput(widget::Widget* output) {
+    addChild(output);
+  }
+
+  virtual void appendContextMenu(ui::Menu* menu) {}
+};
+
+struct ParamWidget : widget::OpaqueWidget {};
+struct PortWidget : widget::OpaqueWidget {};
+
+struct SvgKnob : ParamWidget {
+  void setSvg(std::shared_ptr<window::Svg> svg) {}
+};
+struct RoundKnob : SvgKnob {};
+
+struct SvgSwitch : ParamWidget {
+  bool momentary = false;
+  void addFrame(std::shared_ptr<window::Svg> svg) {}
+};
+
+struct SvgSlider : ParamWidget {
+  math::Vec minHandlePos;
+  math::Vec maxHandlePos;
+  widget::Widget* background = NULL;
+  void setBackgroundSvg(std::shared_ptr<window::Svg> svg) {}
+  void setHandleSvg(std::shared_ptr<window::Svg> svg) {}
+};
+
+struct SvgScrew : widget::Widget {};
+struct SvgPort : PortWidget {};
+struct ModuleLightWidget : widget::Widget {};
+
+}
+
+namespace componentlibrary {
+
+struct ScrewSilver : app::SvgScrew {};
+struct PJ301MPort : app::SvgPort {};
+struct CL1362Port : app::SvgPort {};
+
+struct GreenLight : app::ModuleLightWidget {};
+struct RedLight : app::ModuleLightWidget {};
+struct YellowLight : app::ModuleLightWidget {};
+struct GreenRedLight : app::ModuleLightWidget {};
+
+template <typename TBase>
+struct SmallLight : TBase {};
+template <typename TBase>
+struct MediumLight : TBase {};
+template <typename TBase>
+struct LargeLight : TBase {};
+
+}
+using namespace app;
+using namespace componentlibrary;
+
+namespace plugin {
+
+struct Model {
+  std::string slug;
+
+  virtual ~Model() {}
+  virtual engine::Module* createModule() {
+    return NULL;
+  }
+  virtual app::ModuleWidget* createModuleWidget(engine::Module* module) {
+    return NULL;
+  }
+};
+
+struct Plugin {
+  std::vector<Model*> models;
+
+  void addModel(Model* model) {
+    models.push_back(model);
+  }
+};
+
+}
+
+struct Context {
+  window::Window* window = NULL;
+  engine::Engine* engine = NULL;
+};
+
+#define APP ::rack::contextGet()
+
+}
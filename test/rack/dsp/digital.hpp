@@ -0,0 +1,36 @@
+#pragma once
+
+#include "simd/functions.hpp"
+
+namespace rack {
+namespace dsp {
+
+// Rack's schmitt trigger, the float_4 version (the one RRGateBank uses)
+template <typename T = float>
+struct TSchmittTrigger {
+  T state;
+
+  TSchmittTrigger() {
+    reset();
+  }
+
+  void reset() {
+    state = T::mask();
+  }
+
+  // the lanes that went high
+  T process(T in, T offThreshold = 0.f, T onThreshold = 1.f) {
+    T on = (in >= onThreshold);
+    T off = (in <= offThreshold);
+    T triggered = ~state & on;
+    state = on | (state & ~off);
+    return triggered;
+  }
+
+  T isHigh() {
+    return state;
+  }
+};
+
+}
+}
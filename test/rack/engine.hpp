@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <jansson.h>
+#include "common.hpp"
+#include "math.hpp"
+
+namespace rack {
+namespace engine {
+
+struct Param {
+  float value = 0.f;
+
+  float getValue() {
+    return value;
+  }
+  void setValue(float value) {
+    this->value = value;
+  }
+};
+
+struct Light {
+  float value = 0.f;
+
+  float getBrightness() {
+    return value;
+  }
+  void setBrightness(float brightness) {
+    value = brightness;
+  }
+  void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) {
+    value = brightness;
+  }
+};
+
+struct Port {
+  union {
+    float voltages[PORT_MAX_CHANNELS] = {};
+    float value;
+  };
+  // a cable is connected when the port has channels
+  uint8_t channels = 0;
+
+  float getVoltage(int channel = 0) {
+    return voltages[channel];
+  }
+  void setVoltage(float voltage, int channel = 0) {
+    voltages[channel] = voltage;
+  }
+  float* getVoltages(int firstChannel = 0) {
+    return &voltages[firstChannel];
+  }
+  int getChannels() {
+    return channels;
+  }
+  void setChannels(int channels) {
+    this->channels = channels;
+  }
+  bool isConnected() {
+    return channels > 0;
+  }
+};
+
+struct Input : Port {};
+struct Output : Port {};
+
+// what the modules said about their params in config(), the scenarios
+// move the params over their range
+struct ParamQuantity {
+  float minValue = 0.f;
+  float maxValue = 1.f;
+  float defaultValue = 0.f;
+  std::string name;
+
+  virtual ~ParamQuantity() {}
+};
+
+struct Module {
+  int64_t id = -1;
+  plugin::Model* model = NULL;
+
+  std::vector<Param> params;
+  std::vector<Input> inputs;
+  std::vector<Output> outputs;
+  std::vector<Light> lights;
+  std::vector<ParamQuantity*> paramQuantities;
+
+  struct ProcessArgs {
+    float sampleRate;
+    float sampleTime;
+    int64_t frame;
+  };
+
+  Module() {}
+
+  virtual ~Module() {
+    for (ParamQuantity* paramQuantity : paramQuantities)
+      delete paramQuantity;
+  }
+
+  void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+    params.resize(numParams);
+    inputs.resize(numInputs);
+    outputs.resize(numOutputs);
+    lights.resize(numLights);
+    // like Rack, a param nobody configured goes from 0 to 1
+    paramQuantities.resize(numParams, NULL);
+    for (int i = 0; i < numParams; i++)
+      configParam(i, 0.f, 1.f, 0.f);
+  }
+
+  template <class TParamQuantity = ParamQuantity>
+  TParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+    delete paramQuantities[paramId];
+    TParamQuantity* q = new TParamQuantity;
+    q->minValue = minValue;
+    q->maxValue = maxValue;
+    q->defaultValue = defaultValue;
+    q->name = name;
+    paramQuantities[paramId] = q;
+    params[paramId].setValue(defaultValue);
+    return q;
+  }
+
+  void configInput(int portId, std::string name = "") {}
+  void configOutput(int portId, std::string name = "") {}
+  void configLight(int lightId, std::string name = "") {}
+  void configBypass(int inputId, int outputId) {}
+
+  virtual void process(const ProcessArgs& args) {}
+  virtual void onReset() {}
+
+  virtual json_t* dataToJson() {
+    return NULL;
+  }
+  virtual void dataFromJson(json_t* rootJ) {}
+
+  struct AddEvent {};
+  struct RemoveEvent {};
+  struct ResetEvent {};
+  struct SampleRateChangeEvent {
+    float sampleRate;
+    float sampleTime;
+  };
+  virtual void onAdd(const AddEvent& e) {}
+  virtual void onRemove(const RemoveEvent& e) {}
+  virtual void onReset(const ResetEvent& e) {
+    onReset();
+  }
+  virtual void onSampleRateChange(const SampleRateChangeEvent& e) {}
+};
+
+// the engine's clock, the rig moves it forward one block at a time
+struct Engine {
+  float sampleRate = 48000.f;
+  int64_t frame = 0;
+  int64_t blockFrame = 0;
+  double blockTime = 0.0;
+  int blockFrames = 256;
+
+  float getSampleRate() {
+    return sampleRate;
+  }
+  float getSampleTime() {
+    return 1.f / sampleRate;
+  }
+  int64_t getFrame() {
+    return frame;
+  }
+  int64_t getBlockFrame() {
+    return blockFrame;
+  }
+  double getBlockTime() {
+    return blockTime;
+  }
+  int getBlockFrames() {
+    return blockFrames;
+  }
+  double getBlockDuration() {
+    return blockFrames / (double) sampleRate;
+  }
+  double getMeterAverage() {
+    return 0.0;
+  }
+  double getMeterMax() {
+    return 0.0;
+  }
+};
+
+}
+using engine::Module;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "componentlibrary.hpp"
+
+namespace rack {
+
+template <class TModule, class TModuleWidget>
+plugin::Model* createModel(std::string slug) {
+  struct TModel : plugin::Model {
+    engine::Module* createModule() override {
+      TModule* module = new TModule;
+      module->model = this;
+      return module;
+    }
+    app::ModuleWidget* createModuleWidget(engine::Module* module) override {
+      return new TModuleWidget(dynamic_cast<TModule*>(module));
+    }
+  };
+
+  plugin::Model* model = new TModel;
+  model->slug = slug;
+  return model;
+}
+
+template <class TWidget>
+TWidget* createWidget(math::Vec pos) {
+  TWidget* widget = new TWidget;
+  widget->box.pos = pos;
+  return widget;
+}
+
+template <class TWidget>
+TWidget* createWidgetCentered(math::Vec pos) {
+  return createWidget<TWidget>(pos);
+}
+
+template <class TParamWidget>
+TParamWidget* createParam(math::Vec pos, engine::Module* module, int paramId) {
+  return createWidget<TParamWidget>(pos);
+}
+
+template <class TParamWidget>
+TParamWidget* createParamCentered(math::Vec pos, engine::Module* module, int paramId) {
+  return createWidget<TParamWidget>(pos);
+}
+
+template <class TPortWidget>
+TPortWidget* createInputCentered(math::Vec pos, engine::Module* module, int inputId) {
+  return createWidget<TPortWidget>(pos);
+}
+
+template <class TPortWidget>
+TPortWidget* createOutputCentered(math::Vec pos, engine::Module* module, int outputId) {
+  return createWidget<TPortWidget>(pos);
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget* createLightCentered(math::Vec pos, engine::Module* module, int firstLightId) {
+  return createWidget<TModuleLightWidget>(pos);
+}
+
+template <class TMenu = ui::Menu>
+TMenu* createMenu() {
+  return new TMenu;
+}
+
+inline ui::MenuLabel* createMenuLabel(std::string text) {
+  ui::MenuLabel* label = new ui::MenuLabel;
+  label->text = text;
+  return label;
+}
+
+template <class TMenuItem = ui::MenuItem>
+TMenuItem* createMenuItem(std::string text, std::string rightText = "", std::function<void()> action = []() {}, bool disabled = false, bool alwaysConsume = false) {
+  TMenuItem* item = new TMenuItem;
+  item->text = text;
+  item->rightText = rightText;
+  item->disabled = disabled;
+  return item;
+}
+
+template <class TMenuItem = ui::MenuItem>
+ui::MenuItem* createCheckMenuItem(std::string text, std::string rightText, std::function<bool()> checked, std::function<void()> action, bool disabled = false, bool alwaysConsume = false) {
+  return createMenuItem<TMenuItem>(text, rightText, action, disabled);
+}
+
+template <class TMenuItem = ui::MenuItem>
+ui::MenuItem* createBoolMenuItem(std::string text, std::string rightText, std::function<bool()> getter, std::function<void(bool)> setter, bool disabled = false, bool alwaysConsume = false) {
+  return createMenuItem<TMenuItem>(text, rightText, []() {}, disabled);
+}
+
+template <typename T>
+ui::MenuItem* createBoolPtrMenuItem(std::string text, std::string rightText, T* ptr) {
+  return createMenuItem(text, rightText);
+}
+
+template <class TMenuItem = ui::MenuItem>
+ui::MenuItem* createSubmenuItem(std::string text, std::string rightText, std::function<void(ui::Menu*)> createMenu, bool disabled = false) {
+  return createMenuItem<TMenuItem>(text, rightText, []() {}, disabled);
+}
+
+template <class TMenuItem = ui::MenuItem>
+ui::MenuItem* createIndexSubmenuItem(std::string text, std::vector<std::string> labels, std::function<size_t()> getter, std::function<void(size_t)> setter, bool disabled = false, bool alwaysConsume = false) {
+  return createMenuItem<TMenuItem>(text, "", []() {}, disabled);
+}
+
+inline math::Vec mm2px(math::Vec mm) {
+  return mm.mult(75.f / 25.4f);
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+// the headless engine doesn't save or load patches, so the JSON values
+// are never built. the functions only have to be there for the modules'
+// dataToJson() and dataFromJson().
+typedef struct json_t json_t;
+typedef long long json_int_t;
+
+inline json_t* json_object() { return NULL; }
+inline json_t* json_array() { return NULL; }
+inline json_t* json_integer(json_int_t value) { return NULL; }
+inline json_t* json_real(double value) { return NULL; }
+inline json_t* json_boolean(int value) { return NULL; }
+inline json_t* json_string(const char* value) { return NULL; }
+inline void json_decref(json_t* json) {}
+
+inline int json_object_set_new(json_t* object, const char* key, json_t* value) { return -1; }
+inline json_t* json_object_get(const json_t* object, const char* key) { return NULL; }
+inline int json_array_append_new(json_t* array, json_t* value) { return -1; }
+inline size_t json_array_size(const json_t* array) { return 0; }
+inline json_t* json_array_get(const json_t* array, size_t index) { return NULL; }
+
+inline json_int_t json_integer_value(const json_t* json) { return 0; }
+inline double json_real_value(const json_t* json) { return 0.0; }
+inline double json_number_value(const json_t* json) { return 0.0; }
+inline int json_is_true(const json_t* json) { return 0; }
+inline const char* json_string_value(const json_t* json) { return NULL; }
+
+#define json_is_integer(json) ((json) != NULL)
+#define json_is_real(json) ((json) != NULL)
+#define json_is_number(json) ((json) != NULL)
+#define json_is_boolean(json) ((json) != NULL)
+#define json_is_object(json) ((json) != NULL)
+#define json_is_array(json) ((json) != NULL)
+#define json_boolean_value json_is_true
+#define json_object_foreach(object, key, value) for (key = NULL, value = NULL; key; )
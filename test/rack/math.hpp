@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace rack {
+namespace math {
+
+inline int clamp(int x, int a, int b) {
+  return std::max(std::min(x, b), a);
+}
+
+inline float clamp(float x, float a = 0.f, float b = 1.f) {
+  return std::fmax(std::fmin(x, b), a);
+}
+
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) {
+  return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin);
+}
+
+inline float crossfade(float a, float b, float p) {
+  return a + (b - a) * p;
+}
+
+inline bool isNear(float a, float b, float epsilon = 1e-6f) {
+  return std::fabs(a - b) <= epsilon;
+}
+
+struct Vec {
+  float x = 0.f;
+  float y = 0.f;
+
+  Vec() {}
+  Vec(float x, float y) : x(x), y(y) {}
+
+  Vec plus(Vec b) const {
+    return Vec(x + b.x, y + b.y);
+  }
+  Vec minus(Vec b) const {
+    return Vec(x - b.x, y - b.y);
+  }
+  Vec mult(float s) const {
+    return Vec(x * s, y * s);
+  }
+};
+
+struct Rect {
+  Vec pos;
+  Vec size;
+
+  Rect() {}
+  Rect(Vec pos, Vec size) : pos(pos), size(size) {}
+
+  Vec getBottomLeft() const {
+    return Vec(pos.x, pos.y + size.y);
+  }
+  Vec getCenter() const {
+    return pos.plus(size.mult(0.5f));
+  }
+};
+
+}
+using namespace math;
+}
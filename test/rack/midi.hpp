@@ -0,0 +1,319 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include <jansson.h>
+#include "common.hpp"
+
+namespace rack {
+namespace midi {
+
+struct Message {
+  std::vector<uint8_t> bytes;
+  int64_t frame = -1;
+
+  Message() : bytes(3) {}
+
+  int getSize() const {
+    return bytes.size();
+  }
+  void setSize(int size) {
+    bytes.resize(size);
+  }
+
+  uint8_t getChannel() const {
+    return bytes.size() < 1 ? 0 : bytes[0] & 0xf;
+  }
+  void setChannel(uint8_t channel) {
+    if (bytes.size() >= 1)
+      bytes[0] = (bytes[0] & 0xf0) | (channel & 0xf);
+  }
+  uint8_t getStatus() const {
+    return bytes.size() < 1 ? 0 : bytes[0] >> 4;
+  }
+  void setStatus(uint8_t status) {
+    if (bytes.size() >= 1)
+      bytes[0] = (bytes[0] & 0xf) | (status << 4);
+  }
+  uint8_t getNote() const {
+    return bytes.size() < 2 ? 0 : bytes[1];
+  }
+  void setNote(uint8_t note) {
+    if (bytes.size() >= 2)
+      bytes[1] = note & 0x7f;
+  }
+  uint8_t getValue() const {
+    return bytes.size() < 3 ? 0 : bytes[2];
+  }
+  void setValue(uint8_t value) {
+    if (bytes.size() >= 3)
+      bytes[2] = value & 0x7f;
+  }
+
+  int64_t getFrame() const {
+    return frame;
+  }
+  void setFrame(int64_t frame) {
+    this->frame = frame;
+  }
+};
+
+struct Input;
+struct Output;
+
+struct Device {
+  virtual ~Device() {}
+  virtual std::string getName() {
+    return "";
+  }
+};
+
+struct InputDevice : Device {
+  std::set<Input*> subscribed;
+
+  void subscribe(Input* input) {
+    subscribed.insert(input);
+  }
+  void unsubscribe(Input* input) {
+    subscribed.erase(input);
+  }
+  // hands the message to every input on its channel
+  void onMessage(const Message& message);
+};
+
+struct OutputDevice : Device {
+  std::set<Output*> subscribed;
+
+  void subscribe(Output* output) {
+    subscribed.insert(output);
+  }
+  void unsubscribe(Output* output) {
+    subscribed.erase(output);
+  }
+  virtual void sendMessage(const Message& message) {}
+};
+
+struct Driver {
+  virtual ~Driver() {}
+  virtual std::string getName() {
+    return "";
+  }
+
+  virtual std::vector<int> getInputDeviceIds() {
+    return {};
+  }
+  virtual int getDefaultInputDeviceId() {
+    return -1;
+  }
+  virtual std::string getInputDeviceName(int deviceId) {
+    return "";
+  }
+  virtual InputDevice* subscribeInput(int deviceId, Input* input) {
+    return NULL;
+  }
+  virtual void unsubscribeInput(int deviceId, Input* input) {}
+
+  virtual std::vector<int> getOutputDeviceIds() {
+    return {};
+  }
+  virtual int getDefaultOutputDeviceId() {
+    return -1;
+  }
+  virtual std::string getOutputDeviceName(int deviceId) {
+    return "";
+  }
+  virtual OutputDevice* subscribeOutput(int deviceId, Output* output) {
+    return NULL;
+  }
+  virtual void unsubscribeOutput(int deviceId, Output* output) {}
+};
+
+void addDriver(int driverId, Driver* driver);
+std::vector<int> getDriverIds();
+Driver* getDriver(int driverId);
+
+struct Port {
+  int driverId = -1;
+  int deviceId = -1;
+  // -1 for all channels
+  int channel = -1;
+  Driver* driver = NULL;
+  Context* context;
+
+  Port() {
+    context = contextGet();
+  }
+  virtual ~Port() {}
+
+  Driver* getDriver() {
+    return driver;
+  }
+  int getDriverId() {
+    return driverId;
+  }
+  void setDriverId(int driverId) {
+    setDeviceId(-1);
+    driver = midi::getDriver(driverId);
+    this->driverId = driver ? driverId : -1;
+  }
+
+  virtual Device* getDevice() = 0;
+  virtual std::vector<int> getDeviceIds() = 0;
+  virtual int getDefaultDeviceId() = 0;
+  int getDeviceId() {
+    return deviceId;
+  }
+  virtual void setDeviceId(int deviceId) = 0;
+  virtual std::string getDeviceName(int deviceId) = 0;
+
+  virtual std::vector<int> getChannels() = 0;
+  int getChannel() {
+    return channel;
+  }
+  void setChannel(int channel) {
+    this->channel = channel;
+  }
+  std::string getChannelName(int channel) {
+    return channel < 0 ? "All channels" : string::f("Channel %d", channel + 1);
+  }
+
+  json_t* toJson() {
+    return NULL;
+  }
+  void fromJson(json_t* rootJ) {}
+};
+
+struct Input : Port {
+  InputDevice* inputDevice = NULL;
+
+  ~Input() {
+    Input::setDeviceId(-1);
+  }
+
+  void reset() {
+    setDriverId(-1);
+    channel = -1;
+  }
+
+  Device* getDevice() override {
+    return inputDevice;
+  }
+  std::vector<int> getDeviceIds() override {
+    return driver ? driver->getInputDeviceIds() : std::vector<int>();
+  }
+  int getDefaultDeviceId() override {
+    return driver ? driver->getDefaultInputDeviceId() : -1;
+  }
+  void setDeviceId(int deviceId) override {
+    if (driver && this->deviceId >= 0)
+      driver->unsubscribeInput(this->deviceId, this);
+    inputDevice = NULL;
+    this->deviceId = -1;
+
+    if (driver && deviceId >= 0) {
+      inputDevice = driver->subscribeInput(deviceId, this);
+      if (inputDevice)
+        this->deviceId = deviceId;
+    }
+  }
+  std::string getDeviceName(int deviceId) override {
+    return driver ? driver->getInputDeviceName(deviceId) : "";
+  }
+  std::vector<int> getChannels() override {
+    std::vector<int> channels;
+    for (int c = -1; c < 16; c++)
+      channels.push_back(c);
+    return channels;
+  }
+
+  virtual void onMessage(const Message& message) {}
+};
+
+// the engine thread pops what arrived up to its frame
+struct InputQueue : Input {
+  std::vector<Message> queue;
+
+  void onMessage(const Message& message) override {
+    queue.push_back(message);
+  }
+
+  bool tryPop(Message* messageOut, int64_t maxFrame) {
+    if (queue.empty() || queue.front().getFrame() > maxFrame)
+      return false;
+    *messageOut = queue.front();
+    queue.erase(queue.begin());
+    return true;
+  }
+
+  size_t size() {
+    return queue.size();
+  }
+};
+
+inline void InputDevice::onMessage(const Message& message) {
+  for (Input* input : subscribed) {
+    // the channel filter of Rack's input ports
+    if (input->channel < 0 || message.getStatus() == 0xf || message.getChannel() == input->channel)
+      input->onMessage(message);
+  }
+}
+
+struct Output : Port {
+  OutputDevice* outputDevice = NULL;
+
+  ~Output() {
+    Output::setDeviceId(-1);
+  }
+
+  void reset() {
+    setDriverId(-1);
+    channel = 0;
+  }
+
+  Device* getDevice() override {
+    return outputDevice;
+  }
+  std::vector<int> getDeviceIds() override {
+    return driver ? driver->getOutputDeviceIds() : std::vector<int>();
+  }
+  int getDefaultDeviceId() override {
+    return driver ? driver->getDefaultOutputDeviceId() : -1;
+  }
+  void setDeviceId(int deviceId) override {
+    if (driver && this->deviceId >= 0)
+      driver->unsubscribeOutput(this->deviceId, this);
+    outputDevice = NULL;
+    this->deviceId = -1;
+
+    if (driver && deviceId >= 0) {
+      outputDevice = driver->subscribeOutput(deviceId, this);
+      if (outputDevice)
+        this->deviceId = deviceId;
+    }
+  }
+  std::string getDeviceName(int deviceId) override {
+    return driver ? driver->getOutputDeviceName(deviceId) : "";
+  }
+  std::vector<int> getChannels() override {
+    std::vector<int> channels;
+    for (int c = 0; c < 16; c++)
+      channels.push_back(c);
+    return channels;
+  }
+
+  void sendMessage(const Message& message) {
+    if (!outputDevice)
+      return;
+
+    // like Rack, everything but system messages goes out on the port's channel
+    Message m = message;
+    if (m.getStatus() != 0xf && channel >= 0)
+      m.setChannel(channel);
+    outputDevice->sendMessage(m);
+  }
+};
+
+}
+}
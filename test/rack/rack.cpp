@@ -0,0 +1,59 @@
+#include "rack.hpp"
+#include <atomic>
+#include <map>
+
+namespace rack {
+
+static Context* currentContext = NULL;
+static std::atomic<double> currentTime{0.0};
+
+Context* contextGet() {
+  return currentContext;
+}
+
+void contextSet(Context* context) {
+  currentContext = context;
+}
+
+namespace system {
+
+double getTime() {
+  return currentTime;
+}
+
+}
+
+namespace headless {
+
+void setTime(double time) {
+  currentTime = time;
+}
+
+}
+
+namespace midi {
+
+static std::map<int, Driver*>& drivers() {
+  static std::map<int, Driver*> drivers;
+  return drivers;
+}
+
+void addDriver(int driverId, Driver* driver) {
+  drivers()[driverId] = driver;
+}
+
+std::vector<int> getDriverIds() {
+  std::vector<int> ids;
+  for (auto& it : drivers())
+    ids.push_back(it.first);
+  return ids;
+}
+
+Driver* getDriver(int driverId) {
+  auto it = drivers().find(driverId);
+  return it == drivers().end() ? NULL : it->second;
+}
+
+}
+
+}
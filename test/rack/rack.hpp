@@ -0,0 +1,30 @@
+#pragma once
+
+// a headless stand-in for the parts of the VCV Rack 2 SDK that the modules
+// use, so that src/*.cpp builds and runs without Rack (test/scenarios, the
+// bench and the goldens). the engine only has a clock, MIDI drivers are
+// real (the loopback driver), the widgets never get drawn.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <jansson.h>
+#include "common.hpp"
+#include "math.hpp"
+#include "simd/functions.hpp"
+#include "dsp/digital.hpp"
+#include "midi.hpp"
+#include "engine.hpp"
+#include "ui.hpp"
+#include "componentlibrary.hpp"
+#include "helpers.hpp"
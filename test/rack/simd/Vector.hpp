@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <x86intrin.h>
+
+namespace rack {
+namespace simd {
+
+template <typename T, int N>
+struct Vector;
+
+// 4 floats in an SSE register, the parts of Rack's float_4 the modules use
+template <>
+struct Vector<float, 4> {
+  typedef float type;
+  constexpr static int size = 4;
+
+  union {
+    __m128 v;
+    float s[4];
+  };
+
+  Vector() = default;
+  Vector(__m128 v) : v(v) {}
+  Vector(float x) {
+    v = _mm_set1_ps(x);
+  }
+  Vector(float x1, float x2, float x3, float x4) {
+    v = _mm_setr_ps(x1, x2, x3, x4);
+  }
+
+  float& operator[](int i) {
+    return s[i];
+  }
+  const float& operator[](int i) const {
+    return s[i];
+  }
+
+  static Vector zero() {
+    return Vector(_mm_setzero_ps());
+  }
+  static Vector mask() {
+    return Vector(_mm_castsi128_ps(_mm_set1_epi32(-1)));
+  }
+  static Vector load(const float* x) {
+    return Vector(_mm_loadu_ps(x));
+  }
+  void store(float* x) {
+    _mm_storeu_ps(x, v);
+  }
+};
+
+typedef Vector<float, 4> float_4;
+
+inline float_4 operator+(float_4 a, float_4 b) { return _mm_add_ps(a.v, b.v); }
+inline float_4 operator-(float_4 a, float_4 b) { return _mm_sub_ps(a.v, b.v); }
+inline float_4 operator*(float_4 a, float_4 b) { return _mm_mul_ps(a.v, b.v); }
+inline float_4 operator/(float_4 a, float_4 b) { return _mm_div_ps(a.v, b.v); }
+inline float_4 operator&(float_4 a, float_4 b) { return _mm_and_ps(a.v, b.v); }
+inline float_4 operator|(float_4 a, float_4 b) { return _mm_or_ps(a.v, b.v); }
+inline float_4 operator^(float_4 a, float_4 b) { return _mm_xor_ps(a.v, b.v); }
+inline float_4 operator~(float_4 a) { return a ^ float_4::mask(); }
+
+// comparisons return a mask, all bits of a lane set when true
+inline float_4 operator==(float_4 a, float_4 b) { return _mm_cmpeq_ps(a.v, b.v); }
+inline float_4 operator!=(float_4 a, float_4 b) { return _mm_cmpneq_ps(a.v, b.v); }
+inline float_4 operator<(float_4 a, float_4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline float_4 operator<=(float_4 a, float_4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline float_4 operator>(float_4 a, float_4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline float_4 operator>=(float_4 a, float_4 b) { return _mm_cmpge_ps(a.v, b.v); }
+
+}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "simd/Vector.hpp"
+
+namespace rack {
+namespace simd {
+
+inline float_4 fmin(float_4 a, float_4 b) {
+  return _mm_min_ps(a.v, b.v);
+}
+
+inline float_4 fmax(float_4 a, float_4 b) {
+  return _mm_max_ps(a.v, b.v);
+}
+
+inline float_4 fabs(float_4 a) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v);
+}
+
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) {
+  return fmin(fmax(x, a), b);
+}
+
+// a where the mask is set, b elsewhere
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) {
+  return (mask & a) | _mm_andnot_ps(mask.v, b.v);
+}
+
+// the sign bits of the lanes
+inline int movemask(float_4 a) {
+  return _mm_movemask_ps(a.v);
+}
+
+}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include "common.hpp"
+#include "math.hpp"
+
+// the widgets are built by the models but never drawn, the headless engine
+// has no window. everything here only has to compile.
+
+namespace rack {
+
+struct NVGcontext;
+struct NVGcolor {
+  float r, g, b, a;
+};
+
+inline NVGcolor nvgRGBA(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+  NVGcolor color = {r / 255.f, g / 255.f, b / 255.f, a / 255.f};
+  return color;
+}
+inline NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b) {
+  return nvgRGBA(r, g, b, 255);
+}
+
+enum NVGalign {
+  NVG_ALIGN_LEFT = 1,
+  NVG_ALIGN_CENTER = 2,
+  NVG_ALIGN_RIGHT = 4,
+  NVG_ALIGN_TOP = 8,
+  NVG_ALIGN_MIDDLE = 16,
+  NVG_ALIGN_BOTTOM = 32,
+  NVG_ALIGN_BASELINE = 64
+};
+
+inline void nvgBeginPath(NVGcontext* vg) {}
+inline void nvgRect(NVGcontext* vg, float x, float y, float w, float h) {}
+inline void nvgRoundedRect(NVGcontext* vg, float x, float y, float w, float h, float r) {}
+inline void nvgFill(NVGcontext* vg) {}
+inline void nvgFillColor(NVGcontext* vg, NVGcolor color) {}
+inline void nvgFontSize(NVGcontext* vg, float size) {}
+inline void nvgFontFaceId(NVGcontext* vg, int font) {}
+inline void nvgTextAlign(NVGcontext* vg, int align) {}
+inline void nvgTextLetterSpacing(NVGcontext* vg, float spacing) {}
+inline float nvgText(NVGcontext* vg, float x, float y, const char* string, const char* end) {
+  return x;
+}
+inline void nvgScissor(NVGcontext* vg, float x, float y, float w, float h) {}
+inline void nvgResetScissor(NVGcontext* vg) {}
+
+namespace event {
+struct Action {};
+struct Change {};
+}
+
+namespace window {
+
+struct Svg {};
+struct Font {
+  int handle = -1;
+};
+
+struct Window {
+  std::shared_ptr<Svg> loadSvg(const std::string& filename) {
+    return std::make_shared<Svg>();
+  }
+  std::shared_ptr<Font> loadFont(const std::string& filename) {
+    return std::make_shared<Font>();
+  }
+};
+
+}
+
+namespace widget {
+
+struct Widget {
+  math::Rect box;
+  Widget* parent = NULL;
+  std::list<Widget*> children;
+  bool visible = true;
+
+  struct DrawArgs {
+    NVGcontext* vg;
+    math::Rect clipBox;
+  };
+
+  virtual ~Widget() {
+    clearChildren();
+  }
+
+  void addChild(Widget* child) {
+    child->parent = this;
+    children.push_back(child);
+  }
+  void clearChildren() {
+    for (Widget* child : children)
+      delete child;
+    children.clear();
+  }
+
+  virtual void step() {}
+  virtual void draw(const DrawArgs& args) {}
+  virtual void drawLayer(const DrawArgs& args, int layer) {}
+  virtual void onAction(const event::Action& e) {}
+  virtual void onChange(const event::Change& e) {}
+};
+
+struct OpaqueWidget : Widget {};
+struct TransparentWidget : Widget {};
+
+}
+using widget::Widget;
+
+namespace ui {
+
+struct MenuEntry : widget::OpaqueWidget {};
+struct Menu : widget::OpaqueWidget {};
+
+struct MenuLabel : MenuEntry {
+  std::string text;
+};
+
+struct MenuSeparator : MenuEntry {};
+
+struct MenuItem : MenuEntry {
+  std::string text;
+  std::string rightText;
+  bool disabled = false;
+
+  virtual Menu* createChildMenu() {
+    return NULL;
+  }
+};
+
+}
+
+}
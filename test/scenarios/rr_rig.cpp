@@ -0,0 +1,117 @@
+#include "rr_rig.hpp"
+#include <chrono>
+
+// defined in plugin.cpp
+void init(Plugin* p);
+
+const std::vector<plugin::Model*>& RRRig::getModels() {
+  // the plugin is loaded once, like Rack does. it registers the models
+  // and the loopback driver.
+  static Plugin plugin;
+  static bool loaded = false;
+  if (!loaded) {
+    init(&plugin);
+    loaded = true;
+  }
+  return plugin.models;
+}
+
+plugin::Model* RRRig::findModel(const std::string& slug) {
+  for (plugin::Model* model : getModels()) {
+    if (model->slug == slug)
+      return model;
+  }
+  return NULL;
+}
+
+RRRig::RRRig(float sampleRate, int blockFrames, int device) : device(device) {
+  getModels();
+
+  engine.sampleRate = sampleRate;
+  engine.blockFrames = blockFrames;
+  context.engine = &engine;
+  contextSet(&context);
+  headless::setTime(0.0);
+
+  // whatever an earlier rig's aggregator sent after it stopped
+  std::vector<RRLoopbackEvent> events;
+  rrLoopbackDriver->outputs[device].drain(&events);
+}
+
+RRRig::~RRRig() {
+  if (aggregatorLock.owns_lock())
+    aggregatorLock.unlock();
+
+  // the last module lets go of the aggregator, which stops its thread
+  for (RRModule* module : modules)
+    delete module;
+  aggregator.reset();
+}
+
+RRModule* RRRig::addModule(plugin::Model* model, int channel, float byteRate) {
+  RRModule* module = dynamic_cast<RRModule*>(model->createModule());
+  modules.push_back(module);
+
+  // what the MIDI widget does when the device is picked
+  module->midi_out.setByteRate(byteRate);
+  module->midi_out.setDriverId(RR_LOOPBACK_DRIVER_ID);
+  module->midi_out.setChannel(channel);
+  module->midi_out.setDeviceId(device);
+  aggregator = module->midi_out.aggregator;
+  return module;
+}
+
+void RRRig::start() {
+  if (aggregatorLock.owns_lock())
+    return;
+  aggregatorLock = std::unique_lock<std::mutex>(aggregator->mutex);
+
+  // the thread polled while the modules were added, how often depends on
+  // the OS. the round-robin starts with the first module every time.
+  aggregator->nextQueue = 0;
+}
+
+void RRRig::runBlock(const std::function<void(double time)>& step) {
+  double sampleTime = 1.0 / engine.sampleRate;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < engine.blockFrames; i++) {
+    double time = (engine.frame + 1) * sampleTime;
+    step(time);
+
+    Module::ProcessArgs args;
+    args.sampleRate = engine.sampleRate;
+    args.sampleTime = sampleTime;
+    args.frame = engine.frame;
+    for (RRModule* module : modules)
+      module->process(args);
+    engine.frame++;
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  processTime += elapsed.count();
+
+  // the engine moved on to the next block while the device sends what
+  // the last one generated (released one block late)
+  engine.blockFrame = engine.frame;
+  engine.blockTime = engine.frame * sampleTime;
+  double now = engine.blockTime;
+  double end = now + engine.getBlockDuration();
+  while (now < end) {
+    headless::setTime(now);
+    aggregator->setTiming(engine.getBlockFrame(), engine.getBlockTime(), engine.getSampleTime(), engine.getBlockDuration());
+    now = aggregator->poll(now, 0.001);
+  }
+
+  std::vector<RRLoopbackEvent> events;
+  rrLoopbackDriver->outputs[device].drain(&events);
+  for (const RRLoopbackEvent& event : events) {
+    wireBytes += event.size;
+    if (recording)
+      recording->add(event.frame, event.bytes, event.size);
+  }
+}
+
+RRMidiDeviceStats RRRig::getStats() {
+  // the aggregator's own getStats() would wait for the lock the rig holds
+  return aggregator->RRMidiScheduler::getStats();
+}
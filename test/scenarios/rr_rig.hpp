@@ -0,0 +1,57 @@
+#pragma once
+
+#include "rr_module.hpp"
+#include "rr_loopback.hpp"
+#include "core/rr_bytestream.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+
+// the real modules (src/*.cpp) on the headless engine (test/rack). every
+// module sends through its own RRMidiOutput to the RRMidiAggregator of a
+// loopback device (rr_loopback.hpp), which captures the byte stream, so
+// nothing of the control path is stood in for.
+//
+// the engine runs in blocks on a simulated clock. the aggregator's thread
+// waits on the aggregator's lock while the rig runs and the rig makes the
+// same calls as RRMidiAggregator::run() in its place, one pass per
+// millisecond at least, while the next block is processed. that keeps the
+// scheduling deterministic.
+struct RRRig {
+  Context context;
+  engine::Engine engine;
+  int device;
+
+  std::vector<RRModule*> modules;
+  std::shared_ptr<RRMidiAggregator> aggregator;
+  std::unique_lock<std::mutex> aggregatorLock;
+
+  // what reached the loopback device
+  RRByteStream* recording = NULL;
+  uint64_t wireBytes = 0;
+
+  // time spent in the engine's sample loop (seconds), the modules'
+  // process() and the step that sets their params and inputs
+  double processTime = 0.0;
+
+  RRRig(float sampleRate, int blockFrames, int device = 0);
+  ~RRRig();
+
+  // the model with the slug, NULL if there is none
+  static plugin::Model* findModel(const std::string& slug);
+  static const std::vector<plugin::Model*>& getModels();
+
+  // creates a module of the model on the rig's loopback device. the byte
+  // rate applies to the device, the first module sets it.
+  RRModule* addModule(plugin::Model* model, int channel, float byteRate);
+
+  // parks the aggregator's thread, after all modules were added
+  void start();
+
+  // runs one engine block. step is called before every sample, it sets
+  // the params and inputs of the modules.
+  void runBlock(const std::function<void(double time)>& step);
+
+  // the device's numbers, while the rig runs
+  RRMidiDeviceStats getStats();
+};
@@ -0,0 +1,152 @@
+#include "rr_scenarios.hpp"
+#include <cmath>
+
+const char* const RR_SCENARIO_MODULES[] = {
+  "darkworld", "mood", "blooper", "habit", "thermae",
+  "warpedvinyl", "genloss", "preamp_mk2", "cxm1978"
+};
+
+const int RR_NUM_SCENARIO_MODULES = sizeof(RR_SCENARIO_MODULES) / sizeof(RR_SCENARIO_MODULES[0]);
+
+RRScenarioTarget::RRScenarioTarget(RRModule* module) : module(module) {
+  std::vector<bool> knob_params(module->params.size(), false);
+  std::vector<bool> knob_inputs(module->inputs.size(), false);
+  for (size_t i = 0; i < module->num_knob_ccs; i++) {
+    knob_params[module->knob_ccs[i].param] = true;
+    knob_inputs[module->knob_ccs[i].input] = true;
+  }
+
+  for (size_t i = 0; i < knob_params.size(); i++) {
+    if (!knob_params[i])
+      switches.push_back(i);
+  }
+  for (size_t i = 0; i < knob_inputs.size(); i++) {
+    if (!knob_inputs[i])
+      gates.push_back(i);
+  }
+}
+
+// true on the first sample at or after the given time. it compares
+// sample numbers, the times of two neighbouring samples can both round
+// to the wrong side of it.
+static bool at(double time, double sample_time, double when) {
+  return std::llround(time / sample_time) == (int64_t) std::ceil(when / sample_time - 1e-6);
+}
+
+static float param_min(RRScenarioTarget& target, int id) {
+  return target.module->paramQuantities[id]->minValue;
+}
+
+static float param_max(RRScenarioTarget& target, int id) {
+  return target.module->paramQuantities[id]->maxValue;
+}
+
+static float param_default(RRScenarioTarget& target, int id) {
+  return target.module->paramQuantities[id]->defaultValue;
+}
+
+// nothing moves: the dump on startup, then the idle fast path
+static void step_idle(RRScenarioTarget& target, double time, double sample_time) {
+}
+
+// every knob in turn goes to its max and back to its default, 100ms each
+static void step_knobs(RRScenarioTarget& target, double time, double sample_time) {
+  for (size_t k = 0; k < target.module->num_knob_ccs; k++) {
+    int param = target.module->knob_ccs[k].param;
+    double start = 0.05 + 0.1 * k;
+    if (at(time, sample_time, start))
+      target.set_param(param, param_max(target, param));
+    if (at(time, sample_time, start + 0.05))
+      target.set_param(param, param_default(target, param));
+  }
+}
+
+// the first knob sweeps over its range in 200ms
+static void step_knob_sweep(RRScenarioTarget& target, double time, double sample_time) {
+  int param = target.module->knob_ccs[0].param;
+  double phase = std::fmin(std::fmax((time - 0.025) / 0.2, 0.0), 1.0);
+  float min = param_min(target, param);
+  float max = param_max(target, param);
+  target.set_param(param, (float) std::round(min + (max - min) * phase));
+}
+
+// a 0-5V ramp into the CV of the first knob, which is at its max, then
+// the cable is pulled
+static void step_cv(RRScenarioTarget& target, double time, double sample_time) {
+  const RRKnobCC& knob = target.module->knob_ccs[0];
+  if (at(time, sample_time, sample_time))
+    target.set_param(knob.param, param_max(target, knob.param));
+
+  if (time >= 0.05 && time < 0.3)
+    target.set_input(knob.input, true, (float) std::fmin(5.0 * (time - 0.05) / 0.2, 5.0));
+  else if (at(time, sample_time, 0.3))
+    target.set_input(knob.input, false);
+}
+
+// every switch and button in turn goes to its max, its min and back to
+// its default, 50ms each
+static void step_switches(RRScenarioTarget& target, double time, double sample_time) {
+  for (size_t s = 0; s < target.switches.size(); s++) {
+    int param = target.switches[s];
+    double start = 0.05 + 0.15 * s;
+    if (at(time, sample_time, start))
+      target.set_param(param, param_max(target, param));
+    if (at(time, sample_time, start + 0.05))
+      target.set_param(param, param_min(target, param));
+    if (at(time, sample_time, start + 0.1))
+      target.set_param(param, param_default(target, param));
+  }
+}
+
+// every other input in turn is plugged, gets two 10ms pulses 100ms apart
+// and is pulled, 250ms each
+static void step_gates(RRScenarioTarget& target, double time, double sample_time) {
+  for (size_t g = 0; g < target.gates.size(); g++) {
+    int input = target.gates[g];
+    double start = 0.05 + 0.25 * g;
+    if (at(time, sample_time, start) || at(time, sample_time, start + 0.06) || at(time, sample_time, start + 0.16))
+      target.set_input(input, true, 0.f);
+    if (at(time, sample_time, start + 0.05) || at(time, sample_time, start + 0.15))
+      target.set_input(input, true, 5.f);
+    if (at(time, sample_time, start + 0.2))
+      target.set_input(input, false);
+  }
+}
+
+// a 1Hz sine (0-5V) into the CV of every knob
+static void step_cv_lfo(RRScenarioTarget& target, double time, double sample_time) {
+  for (size_t k = 0; k < target.module->num_knob_ccs; k++) {
+    const RRKnobCC& knob = target.module->knob_ccs[k];
+    if (at(time, sample_time, sample_time))
+      target.set_param(knob.param, param_max(target, knob.param));
+    target.set_input(knob.input, true, 2.5f + 2.5f * (float) std::sin(2 * M_PI * (time + k / 6.0)));
+  }
+}
+
+const RRScenario RR_SCENARIOS[] = {
+  {"idle", 0.5, true, step_idle},
+  {"knobs", 0.75, true, step_knobs},
+  {"knob_sweep", 0.25, true, step_knob_sweep},
+  {"cv", 0.4, true, step_cv},
+  {"switches", 2.0, true, step_switches},
+  {"gates", 2.25, true, step_gates},
+  {"cv_lfo", 2.0, false, step_cv_lfo}
+};
+
+const int RR_NUM_SCENARIOS = sizeof(RR_SCENARIOS) / sizeof(RR_SCENARIOS[0]);
+
+void rr_run_scenario(const RRScenario& scenario, RRRig& rig) {
+  std::vector<RRScenarioTarget> targets;
+  for (RRModule* module : rig.modules)
+    targets.emplace_back(module);
+
+  rig.start();
+  int64_t samples = (int64_t) std::llround(scenario.duration * rig.engine.sampleRate);
+  double sample_time = 1.0 / rig.engine.sampleRate;
+  while (rig.engine.frame < samples) {
+    rig.runBlock([&](double time) {
+      for (RRScenarioTarget& target : targets)
+        scenario.step(target, time, sample_time);
+    });
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "rr_rig.hpp"
+
+// scripted param and CV scenarios on the real modules (see rr_rig.hpp),
+// deterministic so that the byte streams they produce can be compared
+// against golden files (test/golden) and their cost can be benchmarked
+// (test/bench).
+//
+// the scenarios work on any module: the knobs come from the module's
+// knob table, every other param is a switch or a button and every other
+// input takes gates (bypass, tap tempo, transport, clock, expression).
+
+// the nine pedals, by slug
+extern const char* const RR_SCENARIO_MODULES[];
+extern const int RR_NUM_SCENARIO_MODULES;
+
+// what a scenario plays with on a module
+struct RRScenarioTarget {
+  RRModule* module;
+  std::vector<int> switches;
+  std::vector<int> gates;
+
+  explicit RRScenarioTarget(RRModule* module);
+
+  void set_param(int id, float value) {
+    module->params[id].setValue(value);
+  }
+  // a disconnected input is unplugged
+  void set_input(int id, bool connected, float voltage = 0.f) {
+    module->inputs[id].setChannels(connected ? 1 : 0);
+    module->inputs[id].setVoltage(voltage);
+  }
+};
+
+struct RRScenario {
+  const char* name;
+  // simulated duration (seconds)
+  double duration;
+  // recorded into a golden file, the others are only benchmarked
+  bool golden;
+  // sets the params and inputs (and presses the buttons) of a sample
+  void (*step)(RRScenarioTarget& target, double time, double sample_time);
+};
+
+extern const RRScenario RR_SCENARIOS[];
+extern const int RR_NUM_SCENARIOS;
+
+// runs the scenario on all of the rig's modules, in engine blocks
+void rr_run_scenario(const RRScenario& scenario, RRRig& rig);